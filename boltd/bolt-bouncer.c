@@ -48,6 +48,7 @@ struct _BoltBouncer
   GObject object;
 
   /* */
+  GMutex           lock;       /* protects authority */
   PolkitAuthority *authority;
 };
 
@@ -62,6 +63,7 @@ bolt_bouncer_finalize (GObject *object)
   BoltBouncer *bouncer = BOLT_BOUNCER (object);
 
   g_clear_object (&bouncer->authority);
+  g_mutex_clear (&bouncer->lock);
 
   G_OBJECT_CLASS (bolt_bouncer_parent_class)->finalize (object);
 }
@@ -69,6 +71,7 @@ bolt_bouncer_finalize (GObject *object)
 static void
 bolt_bouncer_init (BoltBouncer *bouncer)
 {
+  g_mutex_init (&bouncer->lock);
 }
 
 static void
@@ -91,16 +94,37 @@ bouncer_initialize (GInitable    *initable,
                     GCancellable *cancellable,
                     GError      **error)
 {
-  BoltBouncer *bnc = BOLT_BOUNCER (initable);
-
-  bolt_info (LOG_TOPIC ("bouncer"), "initializing polkit");
-  bnc->authority = polkit_authority_get_sync (cancellable, error);
-
-  return bnc->authority != NULL;
+  /* the connection to polkit is only needed for privileged
+   * operations, which are rare, so it is established lazily,
+   * see bouncer_get_authority, to keep the start-up fast */
+  return TRUE;
 }
 
 /* internal methods */
 
+/* called from the worker threads of the method calls, see
+ * bolt-exported.c, hence the lock; once set, the authority
+ * is not changed until the bouncer is finalized */
+static PolkitAuthority *
+bouncer_get_authority (BoltBouncer *bnc,
+                       GError     **error)
+{
+  PolkitAuthority *authority;
+
+  g_mutex_lock (&bnc->lock);
+
+  if (bnc->authority == NULL)
+    {
+      bolt_info (LOG_TOPIC ("bouncer"), "initializing polkit");
+      bnc->authority = polkit_authority_get_sync (NULL, error);
+    }
+
+  authority = bnc->authority;
+  g_mutex_unlock (&bnc->lock);
+
+  return authority;
+}
+
 static gboolean
 bolt_bouncer_check_action (BoltBouncer           *bnc,
                            GDBusMethodInvocation *inv,
@@ -112,15 +136,20 @@ bolt_bouncer_check_action (BoltBouncer           *bnc,
   g_autoptr(PolkitDetails) details = NULL;
   g_autoptr(PolkitAuthorizationResult) res = NULL;
   PolkitCheckAuthorizationFlags flags;
+  PolkitAuthority *authority;
   const char *sender;
 
+  authority = bouncer_get_authority (bnc, error);
+  if (authority == NULL)
+    return FALSE;
+
   sender = g_dbus_method_invocation_get_sender (inv);
 
   subject = polkit_system_bus_name_new (sender);
   details = polkit_details_new ();
 
   flags = POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION;
-  res = polkit_authority_check_authorization_sync (bnc->authority,
+  res = polkit_authority_check_authorization_sync (authority,
                                                    subject,
                                                    action, details,
                                                    flags,
@@ -171,6 +200,10 @@ handle_authorize_method (BoltExported          *exported,
     authorized = TRUE;
   else if (bolt_streq (method_name, "DeviceByUid"))
     authorized = TRUE;
+  else if (bolt_streq (method_name, "QueryDevices"))
+    authorized = TRUE;
+  else if (bolt_streq (method_name, "GetHistory"))
+    authorized = TRUE;
   else if (bolt_streq (method_name, "ListGuards"))
     authorized = TRUE;
 
@@ -178,9 +211,14 @@ handle_authorize_method (BoltExported          *exported,
     {
       PolkitCheckAuthorizationFlags flags;
       g_autoptr(PolkitAuthorizationResult) res = NULL;
+      PolkitAuthority *authority;
+
+      authority = bouncer_get_authority (bnc, error);
+      if (authority == NULL)
+        return FALSE;
 
       flags = POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION;
-      res = polkit_authority_check_authorization_sync (bnc->authority,
+      res = polkit_authority_check_authorization_sync (authority,
                                                        subject,
                                                        action, details,
                                                        flags,
@@ -0,0 +1,263 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "bolt-clock.h"
+
+#define USEC_PER_MSEC 1000LL
+
+/* timers of the virtual clock */
+typedef struct VTimer
+{
+  guint       id;
+  gint64      deadline;  /* in microseconds */
+  gint64      interval;  /* in microseconds */
+  GSourceFunc function;
+  gpointer    data;
+  gboolean    cancelled;
+} VTimer;
+
+/* the real clock is a thin wrapper around the main loop
+ * and the monotonic clock; the virtual clock only moves
+ * when told to via bolt_clock_advance (), which runs all
+ * the timeouts that expire on the way synchronously */
+struct _BoltClock
+{
+  GObject object;
+
+  gboolean virtual;
+
+  /* virtual clock */
+  gint64   now;      /* in microseconds */
+  GList   *timers;   /* sorted by deadline */
+  VTimer  *firing;   /* timer currently dispatched */
+  guint    last_id;
+};
+
+
+G_DEFINE_TYPE (BoltClock,
+               bolt_clock,
+               G_TYPE_OBJECT)
+
+
+static void
+vtimer_free (gpointer data)
+{
+  g_slice_free (VTimer, data);
+}
+
+static gint
+vtimer_compare (gconstpointer a,
+                gconstpointer b)
+{
+  const VTimer *ta = a;
+  const VTimer *tb = b;
+
+  /* equal deadlines keep their order of insertion */
+  if (ta->deadline < tb->deadline)
+    return -1;
+
+  return 1;
+}
+
+static void
+bolt_clock_finalize (GObject *object)
+{
+  BoltClock *clk = BOLT_CLOCK (object);
+
+  g_list_free_full (clk->timers, vtimer_free);
+
+  G_OBJECT_CLASS (bolt_clock_parent_class)->finalize (object);
+}
+
+static void
+bolt_clock_init (BoltClock *clk)
+{
+}
+
+static void
+bolt_clock_class_init (BoltClockClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = bolt_clock_finalize;
+}
+
+/* public methods */
+
+BoltClock *
+bolt_clock_get_default (void)
+{
+  static gsize initialized = 0;
+  static BoltClock *clk = NULL;
+
+  if (g_once_init_enter (&initialized))
+    {
+      clk = g_object_new (BOLT_TYPE_CLOCK, NULL);
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return clk;
+}
+
+BoltClock *
+bolt_clock_new_virtual (void)
+{
+  BoltClock *clk;
+
+  clk = g_object_new (BOLT_TYPE_CLOCK, NULL);
+  clk->virtual = TRUE;
+
+  /* like the real monotonic clock, never start at zero */
+  clk->now = 1;
+
+  return clk;
+}
+
+gboolean
+bolt_clock_is_virtual (BoltClock *clk)
+{
+  g_return_val_if_fail (BOLT_IS_CLOCK (clk), FALSE);
+
+  return clk->virtual;
+}
+
+gint64
+bolt_clock_get_time (BoltClock *clk)
+{
+  g_return_val_if_fail (BOLT_IS_CLOCK (clk), 0);
+
+  if (!clk->virtual)
+    return g_get_monotonic_time ();
+
+  return clk->now;
+}
+
+guint
+bolt_clock_timeout_add (BoltClock  *clk,
+                        guint       interval,
+                        GSourceFunc function,
+                        gpointer    data)
+{
+  VTimer *t;
+
+  g_return_val_if_fail (BOLT_IS_CLOCK (clk), 0);
+  g_return_val_if_fail (function != NULL, 0);
+
+  if (!clk->virtual)
+    return g_timeout_add (interval, function, data);
+
+  t = g_slice_new0 (VTimer);
+  t->id = ++clk->last_id;
+  t->interval = MAX (interval * USEC_PER_MSEC, 1);
+  t->deadline = clk->now + t->interval;
+  t->function = function;
+  t->data = data;
+
+  clk->timers = g_list_insert_sorted (clk->timers, t, vtimer_compare);
+
+  return t->id;
+}
+
+guint
+bolt_clock_timeout_add_seconds (BoltClock  *clk,
+                                guint       interval,
+                                GSourceFunc function,
+                                gpointer    data)
+{
+  g_return_val_if_fail (BOLT_IS_CLOCK (clk), 0);
+
+  if (!clk->virtual)
+    return g_timeout_add_seconds (interval, function, data);
+
+  return bolt_clock_timeout_add (clk, interval * 1000, function, data);
+}
+
+void
+bolt_clock_source_remove (BoltClock *clk,
+                          guint      id)
+{
+  g_return_if_fail (BOLT_IS_CLOCK (clk));
+  g_return_if_fail (id > 0);
+
+  if (!clk->virtual)
+    {
+      g_source_remove (id);
+      return;
+    }
+
+  for (GList *l = clk->timers; l != NULL; l = l->next)
+    {
+      VTimer *t = l->data;
+
+      if (t->id != id)
+        continue;
+
+      clk->timers = g_list_delete_link (clk->timers, l);
+      vtimer_free (t);
+      return;
+    }
+
+  if (clk->firing != NULL && clk->firing->id == id)
+    clk->firing->cancelled = TRUE;
+  else
+    g_critical ("virtual timeout %u not found", id);
+}
+
+void
+bolt_clock_advance (BoltClock *clk,
+                    guint      msec)
+{
+  gint64 target;
+
+  g_return_if_fail (BOLT_IS_CLOCK (clk));
+  g_return_if_fail (clk->virtual);
+
+  target = clk->now + msec * USEC_PER_MSEC;
+
+  while (clk->timers != NULL)
+    {
+      VTimer *t = clk->timers->data;
+      gboolean again;
+
+      if (t->deadline > target)
+        break;
+
+      clk->timers = g_list_delete_link (clk->timers, clk->timers);
+      clk->now = MAX (clk->now, t->deadline);
+
+      clk->firing = t;
+      again = t->function (t->data);
+      clk->firing = NULL;
+
+      if (again && !t->cancelled)
+        {
+          t->deadline = clk->now + t->interval;
+          clk->timers = g_list_insert_sorted (clk->timers, t, vtimer_compare);
+        }
+      else
+        {
+          vtimer_free (t);
+        }
+    }
+
+  clk->now = target;
+}
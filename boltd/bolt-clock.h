@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* BoltClock - monotonic time and timeouts */
+#define BOLT_TYPE_CLOCK bolt_clock_get_type ()
+G_DECLARE_FINAL_TYPE (BoltClock, bolt_clock, BOLT, CLOCK, GObject);
+
+BoltClock *      bolt_clock_get_default (void);
+
+BoltClock *      bolt_clock_new_virtual (void);
+
+gboolean         bolt_clock_is_virtual (BoltClock *clk);
+
+gint64           bolt_clock_get_time (BoltClock *clk);
+
+guint            bolt_clock_timeout_add (BoltClock  *clk,
+                                         guint       interval,
+                                         GSourceFunc function,
+                                         gpointer    data);
+
+guint            bolt_clock_timeout_add_seconds (BoltClock  *clk,
+                                                 guint       interval,
+                                                 GSourceFunc function,
+                                                 gpointer    data);
+
+void             bolt_clock_source_remove (BoltClock *clk,
+                                           guint      id);
+
+/* virtual clock only */
+void             bolt_clock_advance (BoltClock *clk,
+                                     guint      msec);
+
+G_END_DECLS
@@ -30,6 +30,11 @@
 
 #define DEFAULT_POLICY_KEY "DefaultPolicy"
 #define AUTH_MODE_KEY "AuthMode"
+#define COALESCE_WINDOW_KEY "ChangeCoalesceWindow"
+#define COALESCE_WINDOW_MAX 5000 /* in milli-seconds */
+#define IDLE_EXIT_KEY "IdleExitTimeout"
+#define IDLE_EXIT_MAX (24 * 60 * 60) /* in seconds */
+#define UEVENT_SOURCE_KEY "UeventSource"
 
 GKeyFile *
 bolt_config_user_init (void)
@@ -129,3 +134,121 @@ bolt_config_set_auth_mode (GKeyFile   *cfg,
 
   g_key_file_set_string (cfg, DAEMON_GROUP, AUTH_MODE_KEY, authmode);
 }
+
+BoltTri
+bolt_config_load_coalesce_window (GKeyFile *cfg,
+                                  guint    *window,
+                                  GError  **error)
+{
+  g_autoptr(GError) err = NULL;
+  guint64 val;
+
+  g_return_val_if_fail (error == NULL || *error == NULL, TRI_NO);
+  g_return_val_if_fail (window != NULL, TRI_NO);
+
+  if (cfg == NULL)
+    return TRI_NO;
+
+  val = g_key_file_get_uint64 (cfg, DAEMON_GROUP, COALESCE_WINDOW_KEY, &err);
+  if (err != NULL)
+    {
+      int res = bolt_err_notfound (err) ? TRI_NO : TRI_ERROR;
+
+      if (res == TRI_ERROR)
+        bolt_error_propagate (error, &err);
+
+      return res;
+    }
+
+  if (val > COALESCE_WINDOW_MAX)
+    {
+      g_set_error (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                   "invalid coalesce window: %" G_GUINT64_FORMAT " ms "
+                   "(maximum: %d ms)", val, COALESCE_WINDOW_MAX);
+      return TRI_ERROR;
+    }
+
+  *window = (guint) val;
+  return TRI_YES;
+}
+
+BoltTri
+bolt_config_load_idle_exit (GKeyFile *cfg,
+                            guint    *timeout,
+                            GError  **error)
+{
+  g_autoptr(GError) err = NULL;
+  guint64 val;
+
+  g_return_val_if_fail (error == NULL || *error == NULL, TRI_NO);
+  g_return_val_if_fail (timeout != NULL, TRI_NO);
+
+  if (cfg == NULL)
+    return TRI_NO;
+
+  val = g_key_file_get_uint64 (cfg, DAEMON_GROUP, IDLE_EXIT_KEY, &err);
+  if (err != NULL)
+    {
+      int res = bolt_err_notfound (err) ? TRI_NO : TRI_ERROR;
+
+      if (res == TRI_ERROR)
+        bolt_error_propagate (error, &err);
+
+      return res;
+    }
+
+  if (val > IDLE_EXIT_MAX)
+    {
+      g_set_error (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                   "invalid idle exit timeout: %" G_GUINT64_FORMAT " s "
+                   "(maximum: %d s)", val, IDLE_EXIT_MAX);
+      return TRI_ERROR;
+    }
+
+  *timeout = (guint) val;
+  return TRI_YES;
+}
+
+BoltTri
+bolt_config_load_uevent_source (GKeyFile    *cfg,
+                                const char **source,
+                                GError     **error)
+{
+  const char *known[] = {"auto", "udev", "kernel", NULL};
+  g_autoptr(GError) err = NULL;
+  g_autofree char *str = NULL;
+
+  g_return_val_if_fail (error == NULL || *error == NULL, TRI_NO);
+  g_return_val_if_fail (source != NULL, TRI_NO);
+
+  if (cfg == NULL)
+    return TRI_NO;
+
+  str = g_key_file_get_string (cfg, DAEMON_GROUP, UEVENT_SOURCE_KEY, &err);
+  if (str == NULL)
+    {
+      int res = bolt_err_notfound (err) ? TRI_NO : TRI_ERROR;
+
+      if (res == TRI_ERROR)
+        bolt_error_propagate (error, &err);
+
+      return res;
+    }
+
+  g_strstrip (str);
+
+  for (guint i = 0; known[i] != NULL; i++)
+    {
+      if (!g_str_equal (str, known[i]))
+        continue;
+
+      /* NULL means 'auto', i.e. decided at runtime */
+      *source = i > 0 ? known[i] : NULL;
+      return TRI_YES;
+    }
+
+  g_set_error (error, BOLT_ERROR, BOLT_ERROR_CFG,
+               "invalid uevent source: '%s'", str);
+
+  return TRI_ERROR;
+}
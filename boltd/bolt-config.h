@@ -48,4 +48,16 @@ BoltTri   bolt_config_load_auth_mode (GKeyFile     *cfg,
 void      bolt_config_set_auth_mode (GKeyFile   *cfg,
                                      const char *authmode);
 
+BoltTri   bolt_config_load_coalesce_window (GKeyFile *cfg,
+                                            guint    *window,
+                                            GError  **error);
+
+BoltTri   bolt_config_load_idle_exit (GKeyFile *cfg,
+                                      guint    *timeout,
+                                      GError  **error);
+
+BoltTri   bolt_config_load_uevent_source (GKeyFile    *cfg,
+                                          const char **source,
+                                          GError     **error);
+
 G_END_DECLS
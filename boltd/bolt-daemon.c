@@ -37,11 +37,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+/* after (bus) activation, clients are waiting for us
+ * to own the name; warn if that takes longer than this */
+#define STARTUP_BUDGET_MS 250
+
 /* globals */
 static BoltManager *manager = NULL;
 static GMainLoop *main_loop = NULL;
 static guint name_owner_id = 0;
 static guint sigterm_id = 0;
+static gint64 startup_time = 0;
 
 
 static gboolean
@@ -125,6 +130,16 @@ daemon_logger (GLogLevelFlags   level,
   return res;
 }
 
+static void
+on_manager_idle (BoltManager *mgr,
+                 gpointer     user_data)
+{
+  bolt_msg (LOG_TOPIC ("idle"), "nothing to do; shutting down...");
+
+  if (g_main_loop_is_running (main_loop))
+    g_main_loop_quit (main_loop);
+}
+
 static void
 on_bus_acquired (GDBusConnection *connection,
                  const gchar     *name,
@@ -147,6 +162,9 @@ on_bus_acquired (GDBusConnection *connection,
   if (!bolt_manager_export (manager, connection, &error))
     bolt_warn_err (error, LOG_TOPIC ("dbus"), "error exporting the manager");
 
+  g_signal_connect (manager, "idle",
+                    G_CALLBACK (on_manager_idle),
+                    NULL);
 }
 
 static void
@@ -154,7 +172,17 @@ on_name_acquired (GDBusConnection *connection,
                   const gchar     *name,
                   gpointer         user_data)
 {
-  bolt_debug (LOG_TOPIC ("dbus"), "got the name");
+  gint64 dt;
+
+  dt = (g_get_monotonic_time () - startup_time) / 1000;
+
+  if (dt > STARTUP_BUDGET_MS)
+    bolt_warn (LOG_TOPIC ("dbus"), "got the name after %" G_GINT64_FORMAT
+               " ms (budget: %d ms)", dt, STARTUP_BUDGET_MS);
+  else
+    bolt_debug (LOG_TOPIC ("dbus"), "got the name after %" G_GINT64_FORMAT
+                " ms", dt);
+
   bolt_manager_got_the_name (manager);
 }
 
@@ -189,6 +217,8 @@ main (int argc, char **argv)
     { NULL }
   };
 
+  startup_time = g_get_monotonic_time ();
+
   install_signal_hanlder ();
 
   setlocale (LC_ALL, "");
@@ -266,6 +296,10 @@ main (int argc, char **argv)
       name_owner_id = 0;
     }
 
+  /* speed up the next start, see bolt_manager_save_snapshot */
+  if (manager != NULL)
+    bolt_manager_save_snapshot (manager);
+
   g_clear_object (&manager);
 
   bolt_debug ("shutdown complete");
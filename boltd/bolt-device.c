@@ -59,23 +59,29 @@ struct _BoltDevice
 {
   BoltExported object;
 
-  /* device props */
-  char          *uid;
-  char          *name;
-  char          *vendor;
+  /* device props, strings are pooled, see bolt_str_pool_ref */
+  const char    *uid;
+  const char    *name;
+  const char    *vendor;
 
   BoltDeviceType type;
   BoltStatus     status;
 
   /* when device is attached */
   BoltAuthFlags aflags;
-  char         *syspath;
+  const char   *syspath;
+  BoltSysfsDir *sysdir;  /* cached, see device_get_sysdir */
   BoltDomain   *domain;
-  char         *parent;
+  const char   *parent;  /* shares the parent's uid buffer */
+  GStrv         children;
+  gboolean      denied;  /* by a rule, see bolt_device_set_denied */
 
   guint64       conntime;
   guint64       authtime;
 
+  /* authorization in flight, if any */
+  GTask        *authorizing;
+
   /* when device is stored */
   BoltStore   *store;
   BoltPolicy   policy;
@@ -104,6 +110,7 @@ enum {
 
   PROP_AUTHFLAGS,
   PROP_PARENT,
+  PROP_CHILDREN,
   PROP_SYSFS,
   PROP_DOMAIN,
   PROP_CONNTIME,
@@ -139,12 +146,14 @@ bolt_device_finalize (GObject *object)
 
   g_clear_object (&dev->store);
 
-  g_free (dev->uid);
-  g_free (dev->name);
-  g_free (dev->vendor);
+  bolt_str_pool_unref (dev->uid);
+  bolt_str_pool_unref (dev->name);
+  bolt_str_pool_unref (dev->vendor);
 
-  g_free (dev->parent);
-  g_free (dev->syspath);
+  bolt_str_pool_unref (dev->parent);
+  g_strfreev (dev->children);
+  bolt_str_pool_unref (dev->syspath);
+  g_clear_pointer (&dev->sysdir, bolt_sysfs_dir_unref);
   g_clear_object (&dev->domain);
   g_free (dev->label);
 
@@ -211,6 +220,10 @@ bolt_device_get_property (GObject    *object,
       g_value_set_string (value, dev->parent);
       break;
 
+    case PROP_CHILDREN:
+      g_value_set_boxed (value, dev->children);
+      break;
+
     case PROP_SYSFS:
       g_value_set_string (value, dev->syspath);
       break;
@@ -269,17 +282,15 @@ bolt_device_set_property (GObject      *object,
 
     case PROP_UID:
       g_return_if_fail (dev->uid == NULL);
-      dev->uid = g_value_dup_string (value);
+      dev->uid = bolt_str_pool_ref (g_value_get_string (value));
       break;
 
     case PROP_NAME:
-      g_clear_pointer (&dev->name, g_free);
-      dev->name = g_value_dup_string (value);
+      bolt_set_str_pooled (&dev->name, g_value_get_string (value));
       break;
 
     case PROP_VENDOR:
-      g_clear_pointer (&dev->vendor, g_free);
-      dev->vendor = g_value_dup_string (value);
+      bolt_set_str_pooled (&dev->vendor, g_value_get_string (value));
       break;
 
     case PROP_TYPE:
@@ -298,13 +309,19 @@ bolt_device_set_property (GObject      *object,
       break;
 
     case PROP_PARENT:
-      g_clear_pointer (&dev->parent, g_free);
-      dev->parent = g_value_dup_string (value);
+      bolt_set_str_pooled (&dev->parent, g_value_get_string (value));
+      break;
+
+    case PROP_CHILDREN:
+      g_clear_pointer (&dev->children, g_strfreev);
+      dev->children = g_value_dup_boxed (value);
       break;
 
     case PROP_SYSFS:
-      g_clear_pointer (&dev->syspath, g_free);
-      dev->syspath = g_value_dup_string (value);
+      if (!bolt_streq (dev->syspath, g_value_get_string (value)))
+        g_clear_pointer (&dev->sysdir, bolt_sysfs_dir_unref);
+
+      bolt_set_str_pooled (&dev->syspath, g_value_get_string (value));
       break;
 
     case PROP_DOMAIN:
@@ -428,6 +445,13 @@ bolt_device_class_init (BoltDeviceClass *klass)
                          G_PARAM_READWRITE |
                          G_PARAM_STATIC_STRINGS);
 
+  props[PROP_CHILDREN] =
+    g_param_spec_boxed ("children",
+                        "Children", NULL,
+                        G_TYPE_STRV,
+                        G_PARAM_READWRITE |
+                        G_PARAM_STATIC_STRINGS);
+
   props[PROP_SYSFS] =
     g_param_spec_string ("sysfs-path",
                          "SysfsPath", NULL,
@@ -631,9 +655,32 @@ bolt_auth_flags_from_info (BoltDevInfo   *info,
 
 /*  device authorization */
 
+/* must only be called from the main thread */
+static BoltSysfsDir *
+device_get_sysdir (BoltDevice *dev,
+                   gboolean    validate,
+                   GError    **error)
+{
+  if (dev->syspath == NULL)
+    {
+      g_set_error_literal (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                           "device is not connected");
+      return NULL;
+    }
+
+  if (dev->sysdir != NULL &&
+      (!validate || bolt_sysfs_dir_validate (dev->sysdir, NULL)))
+    return dev->sysdir;
+
+  g_clear_pointer (&dev->sysdir, bolt_sysfs_dir_unref);
+  dev->sysdir = bolt_sysfs_dir_open (dev->syspath, dev->uid, error);
+
+  return dev->sysdir;
+}
+
 static gboolean
 device_check_parent_auth (BoltDevice *dev,
-                          DIR        *devdir,
+                          int         devfd,
                           int        *auth)
 {
 
@@ -641,7 +688,7 @@ device_check_parent_auth (BoltDevice *dev,
   g_autoptr(GError) err = NULL;
   gboolean ok;
 
-  parent = bolt_opendir_at (dirfd (devdir), "..", O_RDONLY, &err);
+  parent = bolt_opendir_at (devfd, "..", O_RDONLY, &err);
 
   if (!parent)
     {
@@ -663,9 +710,9 @@ device_check_parent_auth (BoltDevice *dev,
 }
 
 static void
-authorize_adjust_error (BoltDevice *dev,
-                        DIR        *devdir,
-                        GError    **error)
+authorize_adjust_error (BoltDevice   *dev,
+                        BoltSysfsDir *sysdir,
+                        GError      **error)
 {
   GError *err;
   gint auth = -1;
@@ -684,7 +731,7 @@ authorize_adjust_error (BoltDevice *dev,
        */
 
       /* check for a) */
-      ok = bolt_read_int_at (dirfd (devdir), "authorized", &auth, NULL);
+      ok = bolt_sysfs_dir_read_int (sysdir, BOLT_SYSFS_AUTHORIZED, &auth, NULL);
       if (ok && auth > 0)
         {
           g_clear_error (error);
@@ -695,7 +742,7 @@ authorize_adjust_error (BoltDevice *dev,
         }
 
       /* check for b) */
-      ok = device_check_parent_auth (dev, devdir, &auth);
+      ok = device_check_parent_auth (dev, bolt_sysfs_dir_get_fd (sysdir), &auth);
       if (ok && auth < 1)
         {
           /* parent is not authorized, adjust the error */
@@ -717,12 +764,19 @@ authorize_adjust_error (BoltDevice *dev,
 
 typedef struct
 {
-  BoltAuth *auth;
+  BoltAuth     *auth;
+  BoltSysfsDir *sysdir; /* may be NULL */
 
   /* the outer callback  */
   GAsyncReadyCallback callback;
   gpointer            user_data;
 
+  /* authorization pipeline, i.e. the tasks of
+   * child devices that are waiting for us */
+  GMutex     lock;
+  gboolean   done;
+  GPtrArray *chained;
+
 } AuthData;
 
 static void
@@ -731,15 +785,32 @@ auth_data_free (gpointer data)
   AuthData *auth = data;
 
   g_clear_object (&auth->auth);
+  g_clear_pointer (&auth->sysdir, bolt_sysfs_dir_unref);
+  g_clear_pointer (&auth->chained, g_ptr_array_unref);
+  g_mutex_clear (&auth->lock);
   g_slice_free (AuthData, auth);
 }
 
+static GPtrArray *
+auth_data_finish (AuthData *auth_data)
+{
+  GPtrArray *chained;
+
+  g_mutex_lock (&auth_data->lock);
+  auth_data->done = TRUE;
+  chained = g_steal_pointer (&auth_data->chained);
+  g_mutex_unlock (&auth_data->lock);
+
+  return chained;
+}
+
 static gboolean
-authorize_device_internal (BoltDevice *dev,
-                           BoltAuth   *auth,
-                           GError    **error)
+authorize_device_internal (BoltDevice   *dev,
+                           BoltAuth     *auth,
+                           BoltSysfsDir *sysdir,
+                           GError      **error)
 {
-  g_autoptr(DIR) devdir = NULL;
+  g_autoptr(BoltSysfsDir) fresh = NULL;
   BoltKey *key;
   BoltSecurity level;
   gboolean ok;
@@ -747,13 +818,27 @@ authorize_device_internal (BoltDevice *dev,
   key = bolt_auth_get_key (auth);
   level = bolt_auth_get_level (auth);
 
-  devdir = bolt_opendir (dev->syspath, error);
-  if (devdir == NULL)
-    return FALSE;
+  /* the cached handle was validated when the authorization
+   * was prepared; verifying the uid is a single read */
+  if (sysdir == NULL && dev->syspath == NULL)
+    {
+      g_set_error_literal (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                           "device is not connected");
+      return FALSE;
+    }
+  else if (sysdir == NULL)
+    {
+      fresh = bolt_sysfs_dir_open (dev->syspath, dev->uid, error);
 
-  ok = bolt_verify_uid (dirfd (devdir), dev->uid, error);
-  if (!ok)
-    return FALSE;
+      if (fresh == NULL)
+        return FALSE;
+
+      sysdir = fresh;
+    }
+  else if (!bolt_sysfs_dir_verify_uid (sysdir, dev->uid, error))
+    {
+      return FALSE;
+    }
 
   if (key)
     {
@@ -761,7 +846,7 @@ authorize_device_internal (BoltDevice *dev,
 
       bolt_debug (LOG_DEV (dev), LOG_TOPIC ("authorize"), "writing key");
 
-      keyfd = bolt_openat (dirfd (devdir),
+      keyfd = bolt_openat (bolt_sysfs_dir_get_fd (sysdir),
                            "key",
                            O_WRONLY | O_CLOEXEC,
                            0,
@@ -778,35 +863,82 @@ authorize_device_internal (BoltDevice *dev,
   bolt_debug (LOG_DEV (dev), LOG_TOPIC ("authorize"),
               "writing authorization");
 
-  ok = bolt_write_char_at (dirfd (devdir),
+  ok = bolt_write_char_at (bolt_sysfs_dir_get_fd (sysdir),
                            "authorized",
                            level,
                            error);
 
   if (!ok)
-    authorize_adjust_error (dev, devdir, error);
+    authorize_adjust_error (dev, sysdir, error);
 
   return ok;
 }
 
 static void
-authorize_in_thread (GTask        *task,
-                     gpointer      source,
-                     gpointer      context,
-                     GCancellable *cancellable)
+authorize_task_fail (GTask        *task,
+                     const GError *error)
 {
+  g_autoptr(GPtrArray) chained = NULL;
+  AuthData *auth_data;
+
+  auth_data = g_task_get_task_data (task);
+  chained = auth_data_finish (auth_data);
+
+  g_task_return_error (task, g_error_copy (error));
+
+  for (guint i = 0; chained && i < chained->len; i++)
+    authorize_task_fail (g_ptr_array_index (chained, i), error);
+}
+
+static void
+authorize_task_run (GTask *task)
+{
+  g_autoptr(GPtrArray) chained = NULL;
+  g_autoptr(GError) chain_error = NULL;
   GError *error = NULL;
-  BoltDevice *dev = source;
-  AuthData *auth_data = context;
-  BoltAuth *auth = auth_data->auth;
+  BoltDevice *dev;
+  AuthData *auth_data;
   gboolean ok;
 
-  ok = authorize_device_internal (dev, auth, &error);
+  dev = g_task_get_source_object (task);
+  auth_data = g_task_get_task_data (task);
+
+  ok = authorize_device_internal (dev, auth_data->auth,
+                                  auth_data->sysdir, &error);
+
+  /* after this, no more children can be added to the chain */
+  chained = auth_data_finish (auth_data);
+
+  if (!ok)
+    g_set_error_literal (&chain_error, BOLT_ERROR, BOLT_ERROR_AUTHCHAIN,
+                         "parent device could not be authorized");
 
   if (!ok)
     g_task_return_error (task, error);
   else
     g_task_return_boolean (task, TRUE);
+
+  /* the children are dispatched right here, directly after
+   * the authorization of the parent was written, instead of
+   * after a round trip through the main loop */
+  for (guint i = 0; chained && i < chained->len; i++)
+    {
+      GTask *child = g_ptr_array_index (chained, i);
+
+      if (ok)
+        authorize_task_run (child);
+      else
+        authorize_task_fail (child, chain_error);
+    }
+}
+
+static void
+authorize_in_thread (GTask        *task,
+                     gpointer      source,
+                     gpointer      context,
+                     GCancellable *cancellable)
+{
+  authorize_task_run (task);
 }
 
 static void
@@ -829,6 +961,9 @@ authorize_thread_done (GObject      *object,
   auth_data = g_task_get_task_data (task);
   auth = auth_data->auth;
 
+  if (dev->authorizing == task)
+    dev->authorizing = NULL;
+
   ok = g_task_propagate_boolean (task, &error);
 
   if (!ok)
@@ -858,9 +993,9 @@ authorize_thread_done (GObject      *object,
   g_object_thaw_notify (object);
 
   if (dev->store)
-    bolt_store_put_times (dev->store, dev->uid, NULL,
-                          "authtime", now,
-                          NULL);
+    bolt_store_queue_times (dev->store, dev->uid,
+                            "authtime", now,
+                            NULL);
 
   if (auth_data->callback)
     auth_data->callback (G_OBJECT (dev),
@@ -893,12 +1028,20 @@ authorize_prepare (BoltDevice         *dev,
     }
 
   task = g_task_new (dev, NULL, authorize_thread_done, NULL);
-  auth_data = g_slice_new (AuthData);
+  auth_data = g_slice_new0 (AuthData);
   auth_data->callback = callback;
   auth_data->user_data = user_data;
   auth_data->auth = g_object_ref (auth);
+  g_mutex_init (&auth_data->lock);
+
+  /* failures are reported by the authorization itself */
+  auth_data->sysdir = device_get_sysdir (dev, TRUE, NULL);
+  if (auth_data->sysdir != NULL)
+    bolt_sysfs_dir_ref (auth_data->sysdir);
   g_task_set_task_data (task, auth_data, auth_data_free);
 
+  dev->authorizing = task;
+
   g_object_set (dev, "status", BOLT_STATUS_AUTHORIZING, NULL);
 
   lvl = bolt_auth_get_level (auth);
@@ -1063,6 +1206,12 @@ handle_authorize (BoltExported          *object,
                            "device has no domain associated");
       return NULL;
     }
+  else if (dev->denied)
+    {
+      g_set_error_literal (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                           "authorization denied by rule");
+      return NULL;
+    }
 
   level = bolt_domain_get_security (dev->domain);
   key = NULL;
@@ -1157,6 +1306,122 @@ bolt_device_new_for_udev (struct udev_device *udev,
   return dev;
 }
 
+BoltDevice *
+bolt_device_new_from_snapshot (GKeyFile   *kf,
+                               const char *group,
+                               BoltDomain *domain,
+                               GError    **error)
+{
+  g_autofree char *uid = NULL;
+  g_autofree char *name = NULL;
+  g_autofree char *vendor = NULL;
+  g_autofree char *type = NULL;
+  g_autofree char *status = NULL;
+  g_autofree char *aflags = NULL;
+  g_autofree char *syspath = NULL;
+  g_autofree char *parent = NULL;
+  GError *err = NULL;
+  GEnumClass *klass;
+  gint dt, st;
+  guint flags = 0;
+  guint64 ct, at;
+  gboolean ok;
+
+  g_return_val_if_fail (kf != NULL, NULL);
+  g_return_val_if_fail (group != NULL, NULL);
+  g_return_val_if_fail (domain != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  uid = g_key_file_get_string (kf, group, "uid", &err);
+  if (uid != NULL)
+    name = g_key_file_get_string (kf, group, "name", &err);
+  if (name != NULL)
+    vendor = g_key_file_get_string (kf, group, "vendor", &err);
+  if (vendor != NULL)
+    type = g_key_file_get_string (kf, group, "type", &err);
+  if (type != NULL)
+    status = g_key_file_get_string (kf, group, "status", &err);
+  if (status != NULL)
+    aflags = g_key_file_get_string (kf, group, "authflags", &err);
+  if (aflags != NULL)
+    syspath = g_key_file_get_string (kf, group, "syspath", &err);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return NULL;
+    }
+
+  /* the parent is missing for the host */
+  parent = g_key_file_get_string (kf, group, "parent", NULL);
+  ct = g_key_file_get_uint64 (kf, group, "conntime", NULL);
+  at = g_key_file_get_uint64 (kf, group, "authtime", NULL);
+
+  klass = g_type_class_ref (BOLT_TYPE_DEVICE_TYPE);
+  ok = bolt_enum_class_from_string (klass, type, &dt, error);
+  g_type_class_unref (klass);
+
+  if (!ok)
+    return NULL;
+
+  klass = g_type_class_ref (BOLT_TYPE_STATUS);
+  ok = bolt_enum_class_from_string (klass, status, &st, error);
+  g_type_class_unref (klass);
+
+  if (!ok)
+    return NULL;
+
+  ok = bolt_flags_from_string (BOLT_TYPE_AUTH_FLAGS, aflags, &flags, error);
+  if (!ok)
+    return NULL;
+
+  return g_object_new (BOLT_TYPE_DEVICE,
+                       "uid", uid,
+                       "name", name,
+                       "vendor", vendor,
+                       "type", dt,
+                       "status", st,
+                       "authflags", flags,
+                       "sysfs-path", syspath,
+                       "domain", domain,
+                       "parent", parent,
+                       "conntime", ct,
+                       "authtime", at,
+                       NULL);
+}
+
+void
+bolt_device_save_snapshot (BoltDevice *dev,
+                           GKeyFile   *kf,
+                           const char *group)
+{
+  g_autofree char *aflags = NULL;
+  const char *type;
+  const char *status;
+
+  g_return_if_fail (BOLT_IS_DEVICE (dev));
+  g_return_if_fail (kf != NULL);
+  g_return_if_fail (group != NULL);
+
+  type = bolt_enum_to_string (BOLT_TYPE_DEVICE_TYPE, dev->type, NULL);
+  status = bolt_enum_to_string (BOLT_TYPE_STATUS, dev->status, NULL);
+  aflags = bolt_flags_to_string (BOLT_TYPE_AUTH_FLAGS, dev->aflags, NULL);
+
+  g_key_file_set_string (kf, group, "uid", dev->uid);
+  g_key_file_set_string (kf, group, "name", dev->name);
+  g_key_file_set_string (kf, group, "vendor", dev->vendor);
+  g_key_file_set_string (kf, group, "type", type);
+  g_key_file_set_string (kf, group, "status", status);
+  g_key_file_set_string (kf, group, "authflags", aflags);
+  g_key_file_set_string (kf, group, "syspath", dev->syspath);
+
+  if (dev->parent)
+    g_key_file_set_string (kf, group, "parent", dev->parent);
+
+  g_key_file_set_uint64 (kf, group, "conntime", dev->conntime);
+  g_key_file_set_uint64 (kf, group, "authtime", dev->authtime);
+}
+
 const char *
 bolt_device_export (BoltDevice      *device,
                     GDBusConnection *connection,
@@ -1220,6 +1485,56 @@ bolt_device_authorize_idle (BoltDevice         *dev,
   g_idle_add (authorize_device_idle, task);
 }
 
+void
+bolt_device_authorize_after (BoltDevice         *dev,
+                             BoltDevice         *parent,
+                             BoltAuth           *auth,
+                             GAsyncReadyCallback callback,
+                             gpointer            user_data)
+{
+  GTask *task = NULL;
+  AuthData *pdata;
+  gboolean queued = FALSE;
+
+  g_return_if_fail (BOLT_IS_DEVICE (dev));
+  g_return_if_fail (BOLT_IS_DEVICE (parent));
+  g_return_if_fail (BOLT_IS_AUTH (auth));
+
+  task = authorize_prepare (dev, auth, callback, user_data);
+
+  if (task == NULL)
+    return;
+
+  /* if the parent has an authorization in flight, that
+   * has not yet been written to sysfs, we chain ourselves
+   * to it; the worker thread will then authorize us right
+   * after the parent, see authorize_task_run () */
+  if (parent->authorizing != NULL)
+    {
+      pdata = g_task_get_task_data (parent->authorizing);
+
+      g_mutex_lock (&pdata->lock);
+      queued = !pdata->done;
+
+      if (queued && pdata->chained == NULL)
+        pdata->chained = g_ptr_array_new_with_free_func (g_object_unref);
+
+      if (queued)
+        g_ptr_array_add (pdata->chained, task);
+
+      g_mutex_unlock (&pdata->lock);
+    }
+
+  if (queued)
+    {
+      bolt_info (LOG_DEV (dev), LOG_TOPIC ("authorize"),
+                 "chained to parent authorization");
+      return;
+    }
+
+  g_idle_add (authorize_device_idle, task);
+}
+
 BoltStatus
 bolt_device_connected (BoltDevice         *dev,
                        BoltDomain         *domain,
@@ -1258,10 +1573,10 @@ bolt_device_connected (BoltDevice         *dev,
 
   bolt_info (LOG_DEV (dev), "parent is %.13s...", dev->parent);
 
-  bolt_store_put_times (dev->store, dev->uid, NULL,
-                        "conntime", ct,
-                        "authtime", at,
-                        NULL);
+  bolt_store_queue_times (dev->store, dev->uid,
+                          "conntime", ct,
+                          "authtime", at,
+                          NULL);
   return status;
 }
 
@@ -1308,6 +1623,7 @@ bolt_device_update_from_udev (BoltDevice         *dev,
                               struct udev_device *udev)
 {
   g_autoptr(GError) err = NULL;
+  BoltSysfsDir *sysdir;
   BoltAuthFlags aflags;
   BoltDevInfo info;
   BoltStatus status;
@@ -1327,7 +1643,15 @@ bolt_device_update_from_udev (BoltDevice         *dev,
   if (dev->status == BOLT_STATUS_AUTHORIZING)
     return dev->status;
 
-  ok = bolt_sysfs_info_for_device (udev, FALSE, &info, &err);
+  sysdir = device_get_sysdir (dev, FALSE, NULL);
+  ok = sysdir != NULL && bolt_sysfs_dir_info (sysdir, &info, NULL);
+
+  /* stale handle, e.g. the device was replaced */
+  if (!ok)
+    {
+      g_clear_pointer (&dev->sysdir, bolt_sysfs_dir_unref);
+      ok = bolt_sysfs_info_for_device (udev, FALSE, &info, &err);
+    }
 
   if (!ok)
     {
@@ -1347,9 +1671,9 @@ bolt_device_update_from_udev (BoltDevice         *dev,
       dev->authtime = bolt_now_in_seconds ();
       g_object_notify_by_pspec (G_OBJECT (dev), props[PROP_AUTHTIME]);
 
-      bolt_store_put_times (dev->store, dev->uid, NULL,
-                            "authtime", dev->authtime,
-                            NULL);
+      bolt_store_queue_times (dev->store, dev->uid,
+                              "authtime", dev->authtime,
+                              NULL);
     }
 
   chg = bolt_flags_update (aflags, &dev->aflags, mask);
@@ -1363,6 +1687,14 @@ bolt_device_update_from_udev (BoltDevice         *dev,
   return status;
 }
 
+BoltDomain *
+bolt_device_get_domain (BoltDevice *dev)
+{
+  g_return_val_if_fail (BOLT_IS_DEVICE (dev), NULL);
+
+  return dev->domain;
+}
+
 BoltKeyState
 bolt_device_get_keystate (BoltDevice *dev)
 {
@@ -1406,6 +1738,31 @@ bolt_device_get_uid (BoltDevice *dev)
   return dev->uid;
 }
 
+gboolean
+bolt_device_is_denied (BoltDevice *dev)
+{
+  g_return_val_if_fail (BOLT_IS_DEVICE (dev), FALSE);
+
+  return dev->denied;
+}
+
+void
+bolt_device_set_denied (BoltDevice *dev,
+                        gboolean    denied)
+{
+  g_return_if_fail (BOLT_IS_DEVICE (dev));
+
+  dev->denied = denied;
+}
+
+const char *
+bolt_device_get_parent_uid (BoltDevice *dev)
+{
+  g_return_val_if_fail (BOLT_IS_DEVICE (dev), NULL);
+
+  return dev->parent;
+}
+
 BoltSecurity
 bolt_device_get_security (BoltDevice *dev)
 {
@@ -37,6 +37,15 @@ BoltDevice *      bolt_device_new_for_udev (struct udev_device *udev,
                                             BoltDomain         *domain,
                                             GError            **error);
 
+BoltDevice *      bolt_device_new_from_snapshot (GKeyFile   *kf,
+                                                 const char *group,
+                                                 BoltDomain *domain,
+                                                 GError    **error);
+
+void              bolt_device_save_snapshot (BoltDevice *dev,
+                                             GKeyFile   *kf,
+                                             const char *group);
+
 const char *      bolt_device_export (BoltDevice      *device,
                                       GDBusConnection *connection,
                                       GError         **error);
@@ -53,6 +62,11 @@ gboolean          bolt_device_is_connected (BoltDevice *device);
 
 gboolean          bolt_device_is_authorized (BoltDevice *device);
 
+gboolean          bolt_device_is_denied (BoltDevice *dev);
+
+void              bolt_device_set_denied (BoltDevice *dev,
+                                          gboolean    denied);
+
 BoltStatus        bolt_device_update_from_udev (BoltDevice         *dev,
                                                 struct udev_device *udev);
 
@@ -66,6 +80,14 @@ void              bolt_device_authorize_idle (BoltDevice         *dev,
                                               GAsyncReadyCallback callback,
                                               gpointer            user_data);
 
+void              bolt_device_authorize_after (BoltDevice         *dev,
+                                               BoltDevice         *parent,
+                                               BoltAuth           *auth,
+                                               GAsyncReadyCallback callback,
+                                               gpointer            user_data);
+
+BoltDomain *      bolt_device_get_domain (BoltDevice *dev);
+
 BoltKeyState      bolt_device_get_keystate (BoltDevice *dev);
 
 const char *      bolt_device_get_name (BoltDevice *dev);
@@ -76,6 +98,8 @@ BoltPolicy        bolt_device_get_policy (BoltDevice *dev);
 
 const char *      bolt_device_get_uid (BoltDevice *dev);
 
+const char *      bolt_device_get_parent_uid (BoltDevice *dev);
+
 BoltSecurity      bolt_device_get_security (BoltDevice *dev);
 
 gboolean          bolt_device_get_stored (BoltDevice *dev);
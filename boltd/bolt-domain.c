@@ -51,9 +51,10 @@ struct _BoltDomain
 
   /* sysfs */
   char        *id;
-  char        *syspath;
-  BoltSecurity security;
-  GStrv        bootacl;
+  char         *syspath;
+  BoltSysfsDir *sysdir;   /* cached, for boot_acl reads */
+  BoltSecurity  security;
+  GStrv         bootacl;
 };
 
 
@@ -100,6 +101,7 @@ bolt_domain_finalize (GObject *object)
   g_free (dom->uid);
   g_free (dom->id);
   g_free (dom->syspath);
+  g_clear_pointer (&dom->sysdir, bolt_sysfs_dir_unref);
   g_strfreev (dom->bootacl);
 
   G_OBJECT_CLASS (bolt_domain_parent_class)->finalize (object);
@@ -748,6 +750,7 @@ bolt_domain_disconnected (BoltDomain *domain)
 
   g_clear_pointer (&domain->id, g_free);
   g_clear_pointer (&domain->syspath, g_free);
+  g_clear_pointer (&domain->sysdir, bolt_sysfs_dir_unref);
 
   g_object_notify_by_pspec (G_OBJECT (domain), props[PROP_ID]);
   g_object_notify_by_pspec (G_OBJECT (domain), props[PROP_SYSPATH]);
@@ -766,7 +769,25 @@ bolt_domain_update_from_udev (BoltDomain         *domain,
   g_return_if_fail (BOLT_IS_DOMAIN (domain));
   g_return_if_fail (udev != NULL);
 
-  ok = bolt_sysfs_read_boot_acl (udev, &acl, &err);
+  if (domain->sysdir != NULL &&
+      !bolt_streq (bolt_sysfs_dir_get_path (domain->sysdir), domain->syspath))
+    g_clear_pointer (&domain->sysdir, bolt_sysfs_dir_unref);
+
+  if (domain->sysdir == NULL && domain->syspath != NULL)
+    domain->sysdir = bolt_sysfs_dir_open (domain->syspath, NULL, NULL);
+
+  if (domain->sysdir != NULL)
+    ok = bolt_sysfs_dir_read_boot_acl (domain->sysdir, &acl, NULL);
+  else
+    ok = FALSE;
+
+  /* fall back to udev, which also reports the error */
+  if (!ok)
+    {
+      g_clear_pointer (&domain->sysdir, bolt_sysfs_dir_unref);
+      ok = bolt_sysfs_read_boot_acl (udev, &acl, &err);
+    }
+
   if (!ok)
     {
       bolt_warn_err (err, "failed to get boot_acl");
@@ -56,6 +56,9 @@ static void       bolt_exported_method_free (gpointer data);
 
 static void       bolt_exported_prop_free (gpointer data);
 
+static gboolean   bolt_exported_emit_props_changed (BoltExported *exported,
+                                                    GPtrArray    *changed);
+
 static GVariant * bolt_exported_prop_gvalue_to_gvariant (BoltExportedProp *prop,
                                                          const GValue     *value);
 
@@ -107,10 +110,18 @@ typedef struct _BoltExportedPrivate
   /* if exported */
   guint registration;
 
-  /* property changes */
+  /* property changes, held back while the
+   * outgoing signal queue is congested */
   GPtrArray *props_changed;
   guint      props_changed_id;
 
+  /* signal to emit after signals were dropped */
+  char      *resync_signal;
+
+  /* immutable a{sv} of all exported properties, rebuilt
+   * lazily after changes, see bolt_exported_get_snapshot */
+  GVariant  *props_snapshot;
+
 } BoltExportedPrivate;
 
 static gpointer bolt_exported_parent_class = NULL;
@@ -192,6 +203,8 @@ bolt_exported_finalize (GObject *object)
     bolt_exported_unexport (exported);
 
   g_clear_pointer (&priv->object_path, g_free);
+  g_clear_pointer (&priv->resync_signal, g_free);
+  g_clear_pointer (&priv->props_snapshot, g_variant_unref);
   g_ptr_array_free (priv->props_changed, TRUE);
 
   G_OBJECT_CLASS (bolt_exported_parent_class)->finalize (object);
@@ -439,6 +452,269 @@ bolt_exported_make_object_path (BoltExported *exported)
   return g_strdup ("/");
 }
 
+/* outgoing signal queue
+ *
+ * GDBus queues outgoing messages without bound, so if the bus
+ * does not keep up, e.g. because the bus daemon is busy serving
+ * stalled subscribers, signal storms (uevents) will make the
+ * queue, and thus our memory, grow. Every signal emitted is
+ * therefore accounted for in a per-connection queue and one
+ * asynchronous flush at a time is used to learn how many of
+ * them have actually been written to the transport.
+ * Above QUEUE_HIGH_WATER, PropertiesChanged are held back and
+ * collapsed per object (they always carry the current value,
+ * so nothing is lost); above QUEUE_LIMIT all signals are dropped
+ * and, once drained, a single resync signal is sent instead.
+ */
+#define QUEUE_HIGH_WATER 128
+#define QUEUE_LOW_WATER   32
+#define QUEUE_LIMIT     1024
+
+typedef struct _BoltSignalQueue
+{
+  GDBusConnection *dbus;     /* not owned, we are attached to it */
+
+  guint            queued;   /* emitted, not known to be written */
+  guint            inflight; /* covered by the current flush */
+  gboolean         flushing;
+
+  gboolean         overflow; /* signals were dropped */
+  BoltExported    *resync;   /* not owned, see unexport */
+
+  GHashTable      *deferred; /* BoltExported (owned) */
+} BoltSignalQueue;
+
+static void        signal_queue_kick (BoltSignalQueue *queue);
+
+static void
+signal_queue_free (gpointer data)
+{
+  BoltSignalQueue *queue = data;
+
+  g_hash_table_unref (queue->deferred);
+  g_free (queue);
+}
+
+static BoltSignalQueue *
+signal_queue_get (GDBusConnection *dbus)
+{
+  static GQuark quark = 0;
+  BoltSignalQueue *queue;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("bolt-signal-queue");
+
+  queue = g_object_get_qdata (G_OBJECT (dbus), quark);
+
+  if (queue != NULL)
+    return queue;
+
+  queue = g_new0 (BoltSignalQueue, 1);
+  queue->dbus = dbus;
+  queue->deferred = g_hash_table_new_full (g_direct_hash,
+                                           g_direct_equal,
+                                           g_object_unref,
+                                           NULL);
+
+  g_object_set_qdata_full (G_OBJECT (dbus), quark, queue,
+                           signal_queue_free);
+
+  return queue;
+}
+
+static gboolean
+signal_queue_is_congested (BoltSignalQueue *queue)
+{
+  /* once we started holding back, keep doing so until
+   * we drained, otherwise the changes would be reordered */
+  return queue->queued >= QUEUE_HIGH_WATER ||
+         g_hash_table_size (queue->deferred) > 0;
+}
+
+/* take ownership first, emitting or unref-ing might re-enter */
+static GPtrArray *
+signal_queue_steal_deferred (BoltSignalQueue *queue)
+{
+  GHashTableIter iter;
+  GPtrArray *objs;
+  gpointer key;
+
+  objs = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_hash_table_iter_init (&iter, queue->deferred);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      g_ptr_array_add (objs, key);
+      g_hash_table_iter_steal (&iter);
+    }
+
+  return objs;
+}
+
+static gboolean
+signal_queue_admit (BoltSignalQueue *queue)
+{
+  g_autoptr(GPtrArray) objs = NULL;
+
+  if (queue->overflow)
+    return FALSE;
+
+  if (queue->queued < QUEUE_LIMIT)
+    return TRUE;
+
+  bolt_warn (LOG_TOPIC ("dbus"), "signal queue full (%u), dropping signals",
+             queue->queued);
+
+  queue->overflow = TRUE;
+
+  /* the resync will cover those */
+  objs = signal_queue_steal_deferred (queue);
+
+  for (guint i = 0; i < objs->len; i++)
+    {
+      BoltExportedPrivate *priv = GET_PRIV (g_ptr_array_index (objs, i));
+      g_ptr_array_set_size (priv->props_changed, 0);
+    }
+
+  return FALSE;
+}
+
+static void
+signal_queue_emitted (BoltSignalQueue *queue)
+{
+  queue->queued++;
+  signal_queue_kick (queue);
+}
+
+static void
+signal_queue_drain (BoltSignalQueue *queue)
+{
+  g_autoptr(GPtrArray) objs = NULL;
+  g_autoptr(GError) err = NULL;
+
+  if (queue->overflow && queue->resync != NULL)
+    {
+      BoltExportedPrivate *priv = GET_PRIV (queue->resync);
+      const char *iface_name;
+      gboolean ok;
+
+      iface_name = bolt_exported_get_iface_name (queue->resync);
+
+      ok = g_dbus_connection_emit_signal (queue->dbus,
+                                          NULL,
+                                          priv->object_path,
+                                          iface_name,
+                                          priv->resync_signal,
+                                          NULL,
+                                          &err);
+
+      if (!ok)
+        bolt_warn_err (err, LOG_TOPIC ("dbus"), "error emitting resync");
+      else
+        signal_queue_emitted (queue);
+
+      bolt_info (LOG_TOPIC ("dbus"), "signal queue drained, resync sent");
+    }
+
+  queue->overflow = FALSE;
+
+  objs = signal_queue_steal_deferred (queue);
+
+  for (guint i = 0; i < objs->len; i++)
+    {
+      BoltExported *exported = g_ptr_array_index (objs, i);
+      BoltExportedPrivate *priv = GET_PRIV (exported);
+
+      /* the held back changes, collapsed into one signal */
+      bolt_exported_emit_props_changed (exported, priv->props_changed);
+      g_ptr_array_set_size (priv->props_changed, 0);
+    }
+}
+
+static void
+signal_queue_flushed (GObject      *source,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+  g_autoptr(GError) err = NULL;
+  GDBusConnection *dbus = G_DBUS_CONNECTION (source);
+  BoltSignalQueue *queue;
+  gboolean ok;
+
+  ok = g_dbus_connection_flush_finish (dbus, res, &err);
+
+  if (!ok && !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CLOSED))
+    bolt_warn_err (err, LOG_TOPIC ("dbus"), "error flushing connection");
+
+  queue = signal_queue_get (dbus);
+
+  /* on error, the messages are gone all the same */
+  queue->queued -= queue->inflight;
+  queue->inflight = 0;
+  queue->flushing = FALSE;
+
+  if (queue->queued <= QUEUE_LOW_WATER)
+    signal_queue_drain (queue);
+
+  signal_queue_kick (queue);
+}
+
+static void
+signal_queue_kick (BoltSignalQueue *queue)
+{
+  if (queue->flushing || queue->queued == 0)
+    return;
+
+  if (g_dbus_connection_is_closed (queue->dbus))
+    {
+      queue->queued = 0;
+      return;
+    }
+
+  queue->flushing = TRUE;
+  queue->inflight = queue->queued;
+
+  /* the async operation keeps a reference on the connection */
+  g_dbus_connection_flush (queue->dbus, NULL, signal_queue_flushed, NULL);
+}
+
+static void
+signal_queue_defer (BoltSignalQueue *queue,
+                    BoltExported    *exported,
+                    GPtrArray       *changed)
+{
+  BoltExportedPrivate *priv = GET_PRIV (exported);
+
+  for (guint i = 0; i < changed->len; i++)
+    {
+      gpointer prop = g_ptr_array_index (changed, i);
+      gboolean known = FALSE;
+
+      /* superseded changes collapse into one */
+      for (guint k = 0; !known && k < priv->props_changed->len; k++)
+        known = g_ptr_array_index (priv->props_changed, k) == prop;
+
+      if (!known)
+        g_ptr_array_add (priv->props_changed, prop);
+    }
+
+  if (!g_hash_table_contains (queue->deferred, exported))
+    g_hash_table_add (queue->deferred, g_object_ref (exported));
+}
+
+static void
+signal_queue_forget (BoltSignalQueue *queue,
+                     BoltExported    *exported)
+{
+  BoltExportedPrivate *priv = GET_PRIV (exported);
+
+  if (queue->resync == exported)
+    queue->resync = NULL;
+
+  g_ptr_array_set_size (priv->props_changed, 0);
+  g_hash_table_remove (queue->deferred, exported);
+}
+
 /* dispatch helper function */
 
 typedef struct _DispatchData
@@ -719,6 +995,7 @@ handle_dbus_get_property (GDBusConnection *connection,
   g_autoptr(GError) err = NULL;
   BoltExported *exported;
   BoltExportedProp *prop;
+  GVariant *snapshot;
   GVariant *ret;
 
   exported = BOLT_EXPORTED (user_data);
@@ -734,39 +1011,98 @@ handle_dbus_get_property (GDBusConnection *connection,
       return NULL;
     }
 
-  ret = bolt_exported_get_prop (exported, prop);
+  /* Get and GetAll are served from the snapshot */
+  snapshot = bolt_exported_get_snapshot (exported);
+  ret = g_variant_lookup_value (snapshot, prop->name_bus, NULL);
+
+  if (ret == NULL)
+    ret = bolt_exported_get_prop (exported, prop);
 
   return ret;
 }
 
-static void
-bolt_exported_dispatch_properties_changed (GObject     *object,
-                                           guint        n_pspecs,
-                                           GParamSpec **pspecs)
+static gboolean
+bolt_exported_emit_props_changed (BoltExported *exported,
+                                  GPtrArray    *changed)
 {
   g_autoptr(GVariant) changes = NULL;
   g_autoptr(GError) err = NULL;
-  g_auto(GVariantBuilder) changed;
+  g_auto(GVariantBuilder) builder;
   g_auto(GVariantBuilder) invalidated;
+  BoltExportedPrivate *priv;
   const char *iface_name;
+  gboolean ok;
+
+  priv = GET_PRIV (exported);
+
+  if (changed->len == 0)
+    return TRUE;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_init (&invalidated, G_VARIANT_TYPE ("as"));
+
+  for (guint i = 0; i < changed->len; i++)
+    {
+      g_autoptr(GVariant) var = NULL;
+      BoltExportedProp *prop = g_ptr_array_index (changed, i);
+
+      var = bolt_exported_get_prop (exported, prop);
+      g_variant_builder_add (&builder, "{sv}", prop->name_bus, var);
+    }
+
+  iface_name = bolt_exported_get_iface_name (exported);
+  changes = g_variant_ref_sink (g_variant_new ("(sa{sv}as)",
+                                               iface_name,
+                                               &builder,
+                                               &invalidated));
+
+  ok = g_dbus_connection_emit_signal (priv->dbus,
+                                      NULL,
+                                      priv->object_path,
+                                      "org.freedesktop.DBus.Properties",
+                                      "PropertiesChanged",
+                                      changes,
+                                      &err);
+
+  if (!ok)
+    {
+      bolt_warn_err (err, LOG_TOPIC ("dbus"),
+                     "error emitting property changes");
+      return FALSE;
+    }
+
+  signal_queue_emitted (signal_queue_get (priv->dbus));
+
+  bolt_debug (LOG_TOPIC ("dbus"), "emitted property %u changes",
+              changed->len);
+
+  return TRUE;
+}
+
+static void
+bolt_exported_dispatch_properties_changed (GObject     *object,
+                                           guint        n_pspecs,
+                                           GParamSpec **pspecs)
+{
+  g_autoptr(GPtrArray) changed = NULL;
+  BoltSignalQueue *queue;
   BoltExported *exported;
   BoltExportedPrivate *priv;
-  gboolean ok;
-  guint count = 0;
 
   exported = BOLT_EXPORTED (object);
   priv = GET_PRIV (exported);
 
-  g_variant_builder_init (&changed, G_VARIANT_TYPE ("a{sv}"));
-  g_variant_builder_init (&invalidated, G_VARIANT_TYPE ("as"));
+  /* whatever changed, the snapshot is stale now */
+  g_clear_pointer (&priv->props_snapshot, g_variant_unref);
 
   /* no bus, no changed signal */
   if (priv->dbus == NULL || priv->object_path == NULL)
     goto out;
 
+  changed = g_ptr_array_sized_new (n_pspecs);
+
   for (guint i = 0; i < n_pspecs; i++)
     {
-      g_autoptr(GVariant) var = NULL;
       GParamSpec *pspec = pspecs[i];
       BoltExportedProp *prop;
       const char *nick;
@@ -781,34 +1117,21 @@ bolt_exported_dispatch_properties_changed (GObject     *object,
         }
 
       bolt_debug (LOG_TOPIC ("dbus"), "prop %s changed", nick);
-
-      var = bolt_exported_get_prop (exported, prop);
-      g_variant_builder_add (&changed, "{sv}", prop->name_bus, var);
-      count++;
+      g_ptr_array_add (changed, prop);
     }
 
-  if (count == 0)
+  if (changed->len == 0)
     goto out;
 
-  iface_name = bolt_exported_get_iface_name (exported);
-  changes = g_variant_ref_sink (g_variant_new ("(sa{sv}as)",
-                                               iface_name,
-                                               &changed,
-                                               &invalidated));
-
-  ok = g_dbus_connection_emit_signal (priv->dbus,
-                                      NULL,
-                                      priv->object_path,
-                                      "org.freedesktop.DBus.Properties",
-                                      "PropertiesChanged",
-                                      changes,
-                                      &err);
+  queue = signal_queue_get (priv->dbus);
 
-  if (!ok)
-    bolt_warn_err (err, LOG_TOPIC ("dbus"),
-                   "error emitting property changes");
+  if (!signal_queue_admit (queue))
+    goto out;
 
-  bolt_debug (LOG_TOPIC ("dbus"), "emitted property %u changes", count);
+  if (signal_queue_is_congested (queue))
+    signal_queue_defer (queue, exported, changed);
+  else
+    bolt_exported_emit_props_changed (exported, changed);
 
 out:
   CHAIN_UP (dispatch_properties_changed) (object, n_pspecs, pspecs);
@@ -1112,6 +1435,9 @@ bolt_exported_export (BoltExported    *exported,
   priv->object_path = g_steal_pointer (&object_path);
   priv->registration = id;
 
+  if (priv->resync_signal != NULL)
+    signal_queue_get (connection)->resync = exported;
+
   g_object_notify_by_pspec (G_OBJECT (exported), props[PROP_OBJECT_PATH]);
   g_object_notify_by_pspec (G_OBJECT (exported), props[PROP_EXPORTED]);
 
@@ -1136,6 +1462,7 @@ bolt_exported_unexport (BoltExported *exported)
 
   if (ok)
     {
+      signal_queue_forget (signal_queue_get (priv->dbus), exported);
       g_clear_object (&priv->dbus);
       priv->registration = 0;
       opath = g_steal_pointer (&priv->object_path);
@@ -1192,6 +1519,7 @@ bolt_exported_emit_signal (BoltExported *exported,
 {
   g_autoptr(GError) err = NULL;
   BoltExportedPrivate *priv;
+  BoltSignalQueue *queue;
   const char *iface_name;
   gboolean ok;
 
@@ -1206,6 +1534,16 @@ bolt_exported_emit_signal (BoltExported *exported,
   if (priv->dbus == NULL || priv->object_path == NULL)
     return TRUE;
 
+  queue = signal_queue_get (priv->dbus);
+
+  if (!signal_queue_admit (queue))
+    {
+      /* not an error: the resync signal will tell */
+      bolt_debug (LOG_TOPIC ("dbus"), "dropped signal: %s", name);
+      g_variant_unref (g_variant_ref_sink (parameters));
+      return TRUE;
+    }
+
   iface_name = bolt_exported_get_iface_name (exported);
 
   ok = g_dbus_connection_emit_signal (priv->dbus,
@@ -1224,12 +1562,98 @@ bolt_exported_emit_signal (BoltExported *exported,
     }
   else
     {
+      signal_queue_emitted (queue);
       bolt_debug (LOG_TOPIC ("dbus"), "emitted signal: %s", name);
     }
 
   return ok;
 }
 
+void
+bolt_exported_set_resync_signal (BoltExported *exported,
+                                 const char   *name)
+{
+  BoltExportedPrivate *priv;
+
+  g_return_if_fail (BOLT_IS_EXPORTED (exported));
+
+  priv = GET_PRIV (exported);
+
+  g_free (priv->resync_signal);
+  priv->resync_signal = g_strdup (name);
+
+  if (priv->dbus == NULL)
+    return;
+
+  if (name != NULL)
+    signal_queue_get (priv->dbus)->resync = exported;
+  else if (signal_queue_get (priv->dbus)->resync == exported)
+    signal_queue_get (priv->dbus)->resync = NULL;
+}
+
+GVariant *
+bolt_exported_get_prop_value (BoltExported *exported,
+                              const char   *name,
+                              GError      **error)
+{
+  BoltExportedProp *prop;
+  GVariant *snapshot;
+  GVariant *res;
+
+  g_return_val_if_fail (BOLT_IS_EXPORTED (exported), NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  prop = bolt_exported_lookup_property (exported, name, error);
+  if (prop == NULL)
+    return NULL;
+
+  snapshot = bolt_exported_get_snapshot (exported);
+  res = g_variant_lookup_value (snapshot, prop->name_bus, NULL);
+
+  if (res != NULL)
+    return res;
+
+  /* never hand out floating references */
+  return g_variant_take_ref (bolt_exported_get_prop (exported, prop));
+}
+
+GVariant *
+bolt_exported_get_snapshot (BoltExported *exported)
+{
+  BoltExportedPrivate *priv;
+  BoltExportedClass *klass;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_return_val_if_fail (BOLT_IS_EXPORTED (exported), NULL);
+
+  priv = GET_PRIV (exported);
+
+  if (priv->props_snapshot != NULL)
+    return priv->props_snapshot;
+
+  klass = BOLT_EXPORTED_GET_CLASS (exported);
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+  g_hash_table_iter_init (&iter, klass->priv->properties);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      BoltExportedProp *prop = value;
+      GVariant *var;
+
+      var = bolt_exported_get_prop (exported, prop);
+
+      if (var != NULL)
+        g_variant_builder_add (&builder, "{sv}", prop->name_bus, var);
+    }
+
+  priv->props_snapshot = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  return priv->props_snapshot;
+}
+
 /* non BoltExported internal methods */
 
 static void
@@ -113,8 +113,17 @@ gboolean           bolt_exported_emit_signal (BoltExported *exported,
                                               GVariant     *parameters,
                                               GError      **error);
 
+void               bolt_exported_set_resync_signal (BoltExported *exported,
+                                                    const char   *name);
+
 void               bolt_exported_flush (BoltExported *exported);
 
+GVariant *         bolt_exported_get_prop_value (BoltExported *exported,
+                                                 const char   *name,
+                                                 GError      **error);
+
+GVariant *         bolt_exported_get_snapshot (BoltExported *exported);
+
 /* helper methods */
 GParamSpec *       bolt_param_spec_override (GObjectClass *object_class,
                                              const char   *name);
@@ -0,0 +1,627 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "bolt-history.h"
+
+#include "bolt-error.h"
+#include "bolt-fs.h"
+#include "bolt-io.h"
+#include "bolt-log.h"
+#include "bolt-macros.h"
+#include "bolt-str.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Every record is a line of exactly RECORD_SIZE bytes:
+ *
+ *   <time:16 hex> <event> <result> <duration:8 hex> <uid, padded>\n
+ *
+ * Records are only ever appended and their time stamps never
+ * decrease, so the file is its own time index: the record for
+ * any point in time can be found via a binary search.
+ *
+ * The time stamps are real time. If the clock is stepped back,
+ * new records get the time stamp of the last record until the
+ * clock catches up again, i.e. for that period the recorded
+ * times are too late, but their order is still correct.
+ */
+#define RECORD_SIZE       80
+#define RECORD_TS_LEN     16
+#define RECORD_EVENT      17
+#define RECORD_RESULT     19
+#define RECORD_DURATION   21
+#define RECORD_UID        30
+#define RECORD_UID_LEN    (RECORD_SIZE - RECORD_UID - 1)
+
+/* records read at once when walking a range */
+#define READ_CHUNK        64
+
+#define DEFAULT_MAX_RECORDS (32 * 1024)
+#define DEFAULT_MAX_AGE     (G_GUINT64_CONSTANT (90) * 24 * 60 * 60 * G_USEC_PER_SEC)
+
+struct _BoltHistory
+{
+  GObject object;
+
+  char   *path;
+  int     fd;
+
+  guint64 count;   /* number of records */
+  guint64 first;   /* time stamp of the first record */
+  guint64 last;    /* time stamp of the last record */
+
+  /* bounds */
+  guint   max_records;
+  guint64 max_age;  /* in microseconds */
+
+  guint   compact_source;  /* idle source, see bolt_history_put */
+};
+
+
+G_DEFINE_TYPE (BoltHistory,
+               bolt_history,
+               G_TYPE_OBJECT)
+
+
+static void
+bolt_history_finalize (GObject *object)
+{
+  BoltHistory *history = BOLT_HISTORY (object);
+
+  if (history->compact_source)
+    g_source_remove (history->compact_source);
+
+  if (history->fd > -1)
+    bolt_close (history->fd, NULL);
+
+  g_free (history->path);
+
+  G_OBJECT_CLASS (bolt_history_parent_class)->finalize (object);
+}
+
+static void
+bolt_history_init (BoltHistory *history)
+{
+  history->fd = -1;
+  history->max_records = DEFAULT_MAX_RECORDS;
+  history->max_age = DEFAULT_MAX_AGE;
+}
+
+static void
+bolt_history_class_init (BoltHistoryClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = bolt_history_finalize;
+}
+
+/* internal methods */
+static gboolean
+history_pread (BoltHistory *history,
+               char        *buf,
+               guint64      index,
+               guint        n,
+               GError     **error)
+{
+  size_t len = (size_t) n * RECORD_SIZE;
+  off_t off = (off_t) (index * RECORD_SIZE);
+  size_t done = 0;
+
+  while (done < len)
+    {
+      ssize_t r = pread (history->fd, buf + done, len - done, off + done);
+
+      if (r == -1 && errno == EINTR)
+        continue;
+
+      if (r <= 0)
+        {
+          int code = r == 0 ? EIO : errno;
+          g_set_error (error, G_IO_ERROR, g_io_error_from_errno (code),
+                       "could not read history: %s", g_strerror (code));
+          return FALSE;
+        }
+
+      done += (size_t) r;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+history_parse_record (const char       *rec,
+                      BoltHistoryEntry *entry,
+                      GError          **error)
+{
+  char tmp[RECORD_TS_LEN + 1];
+  const char *uid;
+  int len;
+
+  if (rec[RECORD_SIZE - 1] != '\n')
+    {
+      g_set_error_literal (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                           "malformed history record");
+      return FALSE;
+    }
+
+  memcpy (tmp, rec, RECORD_TS_LEN);
+  tmp[RECORD_TS_LEN] = '\0';
+  entry->ts = g_ascii_strtoull (tmp, NULL, 16);
+
+  entry->event = rec[RECORD_EVENT];
+  entry->result = rec[RECORD_RESULT];
+
+  memcpy (tmp, rec + RECORD_DURATION, 8);
+  tmp[8] = '\0';
+  entry->duration = (guint32) g_ascii_strtoull (tmp, NULL, 16);
+
+  uid = rec + RECORD_UID;
+  for (len = RECORD_UID_LEN; len > 0 && uid[len - 1] == ' '; len--)
+    ;
+
+  entry->uid = g_strndup (uid, len);
+
+  return TRUE;
+}
+
+static gboolean
+history_read_ts (BoltHistory *history,
+                 guint64      index,
+                 guint64     *ts,
+                 GError     **error)
+{
+  char rec[RECORD_SIZE];
+  char tmp[RECORD_TS_LEN + 1];
+  gboolean ok;
+
+  ok = history_pread (history, rec, index, 1, error);
+  if (!ok)
+    return FALSE;
+
+  memcpy (tmp, rec, RECORD_TS_LEN);
+  tmp[RECORD_TS_LEN] = '\0';
+  *ts = g_ascii_strtoull (tmp, NULL, 16);
+
+  return TRUE;
+}
+
+/* index of the first record with a time stamp >= ts */
+static gboolean
+history_lower_bound (BoltHistory *history,
+                     guint64      ts,
+                     guint64     *index,
+                     GError     **error)
+{
+  guint64 lo = 0;
+  guint64 hi = history->count;
+
+  if (ts <= history->first)
+    hi = 0;
+  else if (ts > history->last)
+    lo = hi;
+
+  while (lo < hi)
+    {
+      guint64 mid = lo + (hi - lo) / 2;
+      guint64 val;
+      gboolean ok;
+
+      ok = history_read_ts (history, mid, &val, error);
+      if (!ok)
+        return FALSE;
+
+      if (val < ts)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  *index = lo;
+  return TRUE;
+}
+
+static gboolean
+history_update_bounds (BoltHistory *history,
+                       GError     **error)
+{
+  struct stat st;
+  gboolean ok;
+
+  ok = bolt_fstat (history->fd, &st, error);
+  if (!ok)
+    return FALSE;
+
+  /* a partial record at the end, e.g. after a crash */
+  if (st.st_size % RECORD_SIZE != 0)
+    {
+      bolt_warn (LOG_TOPIC ("history"), "dropping partial record");
+      ok = bolt_ftruncate (history->fd,
+                           st.st_size - st.st_size % RECORD_SIZE,
+                           error);
+      if (!ok)
+        return FALSE;
+    }
+
+  history->count = (guint64) st.st_size / RECORD_SIZE;
+  history->first = history->last = 0;
+
+  if (history->count == 0)
+    return TRUE;
+
+  ok = history_read_ts (history, 0, &history->first, error);
+
+  if (ok)
+    ok = history_read_ts (history, history->count - 1, &history->last, error);
+
+  return ok;
+}
+
+/* drop records that are too old or too many, by copying
+ * the ones to keep to a new file and replacing the old */
+static gboolean
+history_compact (BoltHistory *history,
+                 guint64      now,
+                 GError     **error)
+{
+  g_autofree char *tmp = NULL;
+  bolt_autoclose int fd = -1;
+  guint64 keep = 0;
+  gboolean ok;
+
+  if (now > history->max_age)
+    {
+      ok = history_lower_bound (history, now - history->max_age,
+                                &keep, error);
+      if (!ok)
+        return FALSE;
+    }
+
+  if (history->count - keep > history->max_records)
+    keep = history->count - history->max_records;
+
+  if (keep == 0)
+    return TRUE;
+
+  tmp = g_strdup_printf ("%s.tmp", history->path);
+  fd = bolt_open (tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666, error);
+
+  if (fd < 0)
+    return FALSE;
+
+  ok = bolt_lseek (history->fd, (off_t) (keep * RECORD_SIZE), SEEK_SET,
+                   NULL, error);
+
+  if (ok)
+    ok = bolt_copy_bytes (history->fd, fd,
+                          (history->count - keep) * RECORD_SIZE,
+                          error);
+
+  if (ok)
+    ok = bolt_fdatasync (fd, error);
+
+  if (ok)
+    ok = bolt_faddflags (fd, O_APPEND, error);
+
+  if (ok)
+    ok = bolt_rename (tmp, history->path, error);
+
+  if (!ok)
+    {
+      (void) unlink (tmp);
+      return FALSE;
+    }
+
+  bolt_swap (history->fd, fd);
+
+  bolt_info (LOG_TOPIC ("history"), "dropped %" G_GUINT64_FORMAT " records",
+             keep);
+
+  return history_update_bounds (history, error);
+}
+
+static gboolean
+history_needs_compaction (BoltHistory *history,
+                          guint64      now)
+{
+  /* some slack, to not compact on every single write */
+  guint max = history->max_records + history->max_records / 8;
+  guint64 age = history->max_age + history->max_age / 8;
+
+  return history->count > max ||
+         (history->count > 0 && history->first + age < now);
+}
+
+static guint64
+history_now (BoltHistory *history)
+{
+  /* time must never go backwards, see the top */
+  return MAX ((guint64) g_get_real_time (), history->last);
+}
+
+static gboolean
+history_compact_idle (gpointer user_data)
+{
+  g_autoptr(GError) err = NULL;
+  BoltHistory *history = user_data;
+  gboolean ok;
+
+  history->compact_source = 0;
+
+  ok = history_compact (history, history_now (history), &err);
+  if (!ok)
+    bolt_warn_err (err, LOG_TOPIC ("history"), "could not compact");
+
+  return G_SOURCE_REMOVE;
+}
+
+/* public methods */
+
+BoltHistory *
+bolt_history_new (GFile      *root,
+                  const char *name,
+                  GError    **error)
+{
+  g_autoptr(BoltHistory) history = NULL;
+  g_autoptr(GError) err = NULL;
+  g_autoptr(GFile) file = NULL;
+  gboolean ok;
+
+  g_return_val_if_fail (G_IS_FILE (root), NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  history = g_object_new (BOLT_TYPE_HISTORY, NULL);
+
+  file = g_file_get_child (root, name);
+
+  ok = bolt_fs_make_parent_dirs (file, &err);
+  if (!ok && !bolt_err_exists (err))
+    {
+      bolt_error_propagate (error, &err);
+      return NULL;
+    }
+
+  history->path = g_file_get_path (file);
+  history->fd = bolt_open (history->path,
+                           O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC,
+                           0666,
+                           error);
+
+  if (history->fd < 0)
+    return NULL;
+
+  ok = history_update_bounds (history, error);
+  if (!ok)
+    return NULL;
+
+  if (history_needs_compaction (history, (guint64) g_get_real_time ()))
+    {
+      ok = history_compact (history, (guint64) g_get_real_time (), &err);
+      if (!ok)
+        bolt_warn_err (err, LOG_TOPIC ("history"), "could not compact");
+    }
+
+  bolt_info (LOG_TOPIC ("history"), "opened; %" G_GUINT64_FORMAT " records",
+             history->count);
+
+  return g_steal_pointer (&history);
+}
+
+void
+bolt_history_set_limits (BoltHistory *history,
+                         guint        max_records,
+                         guint64      max_age)
+{
+  g_return_if_fail (BOLT_IS_HISTORY (history));
+  g_return_if_fail (max_records > 0);
+
+  history->max_records = max_records;
+  history->max_age = max_age;
+}
+
+guint64
+bolt_history_get_count (BoltHistory *history)
+{
+  g_return_val_if_fail (BOLT_IS_HISTORY (history), 0);
+
+  return history->count;
+}
+
+gboolean
+bolt_history_put (BoltHistory      *history,
+                  const char       *uid,
+                  BoltHistoryEvent  event,
+                  BoltHistoryResult result,
+                  guint32           duration,
+                  GError          **error)
+{
+  char rec[RECORD_SIZE + 1];
+  guint64 now;
+  gboolean ok;
+  int n;
+
+  g_return_val_if_fail (BOLT_IS_HISTORY (history), FALSE);
+  g_return_val_if_fail (uid != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (strlen (uid) > (size_t) RECORD_UID_LEN)
+    {
+      g_set_error (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                   "uid too long for history: %s", uid);
+      return FALSE;
+    }
+
+  now = history_now (history);
+
+  n = g_snprintf (rec, sizeof (rec),
+                  "%016" G_GINT64_MODIFIER "X %c %c %08X %-*s\n",
+                  now, event, result, duration, RECORD_UID_LEN, uid);
+
+  g_assert (n == RECORD_SIZE);
+
+  ok = bolt_write_all (history->fd, rec, RECORD_SIZE, error);
+  if (!ok)
+    return FALSE;
+
+  if (history->count == 0)
+    history->first = now;
+
+  history->last = now;
+  history->count++;
+
+  /* copying the records is too much work for the
+   * event handlers we are called from, so do it later */
+  if (history->compact_source == 0 &&
+      history_needs_compaction (history, now))
+    history->compact_source = g_idle_add_full (G_PRIORITY_LOW,
+                                               history_compact_idle,
+                                               history, NULL);
+
+  return TRUE;
+}
+
+GPtrArray *
+bolt_history_query (BoltHistory *history,
+                    const char  *uid,
+                    guint64      since,
+                    guint64      until,
+                    guint        limit,
+                    GError     **error)
+{
+  g_autoptr(GPtrArray) res = NULL;
+  char buf[READ_CHUNK * RECORD_SIZE];
+  guint64 start, end;
+  gboolean ok;
+
+  g_return_val_if_fail (BOLT_IS_HISTORY (history), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  res = g_ptr_array_new_with_free_func ((GDestroyNotify) bolt_history_entry_free);
+
+  if (bolt_strzero (uid))
+    uid = NULL;
+
+  /* [start, end) via the time index, 0 for until means open */
+  ok = history_lower_bound (history, since, &start, error);
+
+  if (ok && until > 0 && until < G_MAXUINT64)
+    ok = history_lower_bound (history, until + 1, &end, error);
+  else
+    end = history->count;
+
+  if (!ok)
+    return NULL;
+
+  /* newest first, stop as soon as we have enough */
+  while (end > start && (limit == 0 || res->len < limit))
+    {
+      guint n = (guint) MIN (end - start, READ_CHUNK);
+
+      end -= n;
+      ok = history_pread (history, buf, end, n, error);
+      if (!ok)
+        return NULL;
+
+      for (guint i = n; i > 0 && (limit == 0 || res->len < limit); i--)
+        {
+          const char *rec = buf + (i - 1) * RECORD_SIZE;
+          BoltHistoryEntry *entry;
+
+          if (uid != NULL && strncmp (rec + RECORD_UID, uid, strlen (uid)))
+            continue;
+
+          entry = g_slice_new0 (BoltHistoryEntry);
+          ok = history_parse_record (rec, entry, error);
+
+          if (!ok)
+            {
+              bolt_history_entry_free (entry);
+              return NULL;
+            }
+
+          /* the prefix matched, but the whole uid did not */
+          if (uid != NULL && !g_str_equal (entry->uid, uid))
+            {
+              bolt_history_entry_free (entry);
+              continue;
+            }
+
+          g_ptr_array_add (res, entry);
+        }
+    }
+
+  return g_steal_pointer (&res);
+}
+
+const char *
+bolt_history_event_to_string (BoltHistoryEvent event)
+{
+  switch (event)
+    {
+    case BOLT_HISTORY_CONNECT:
+      return "connect";
+
+    case BOLT_HISTORY_DISCONNECT:
+      return "disconnect";
+
+    case BOLT_HISTORY_AUTHORIZE:
+      return "authorize";
+
+    case BOLT_HISTORY_ENROLL:
+      return "enroll";
+
+    case BOLT_HISTORY_FORGET:
+      return "forget";
+    }
+
+  return "unknown";
+}
+
+const char *
+bolt_history_result_to_string (BoltHistoryResult result)
+{
+  switch (result)
+    {
+    case BOLT_HISTORY_RESULT_NONE:
+      return "";
+
+    case BOLT_HISTORY_RESULT_OK:
+      return "ok";
+
+    case BOLT_HISTORY_RESULT_FAILED:
+      return "failed";
+    }
+
+  return "unknown";
+}
+
+void
+bolt_history_entry_free (BoltHistoryEntry *entry)
+{
+  if (entry == NULL)
+    return;
+
+  g_free (entry->uid);
+  g_slice_free (BoltHistoryEntry, entry);
+}
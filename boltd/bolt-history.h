@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum BoltHistoryEvent {
+  BOLT_HISTORY_CONNECT    = 'c',
+  BOLT_HISTORY_DISCONNECT = 'd',
+  BOLT_HISTORY_AUTHORIZE  = 'a',
+  BOLT_HISTORY_ENROLL     = 'e',
+  BOLT_HISTORY_FORGET     = 'f',
+} BoltHistoryEvent;
+
+typedef enum BoltHistoryResult {
+  BOLT_HISTORY_RESULT_NONE   = '=',
+  BOLT_HISTORY_RESULT_OK     = '+',
+  BOLT_HISTORY_RESULT_FAILED = '-',
+} BoltHistoryResult;
+
+typedef struct BoltHistoryEntry
+{
+  char             *uid;
+  guint64           ts;        /* real time, in microseconds */
+  BoltHistoryEvent  event;
+  BoltHistoryResult result;
+  guint32           duration;  /* in milliseconds */
+} BoltHistoryEntry;
+
+/* BoltHistory - rolling log of device events */
+#define BOLT_TYPE_HISTORY bolt_history_get_type ()
+G_DECLARE_FINAL_TYPE (BoltHistory, bolt_history, BOLT, HISTORY, GObject);
+
+BoltHistory *      bolt_history_new (GFile      *root,
+                                     const char *name,
+                                     GError    **error);
+
+void               bolt_history_set_limits (BoltHistory *history,
+                                            guint        max_records,
+                                            guint64      max_age);
+
+guint64            bolt_history_get_count (BoltHistory *history);
+
+gboolean           bolt_history_put (BoltHistory      *history,
+                                     const char       *uid,
+                                     BoltHistoryEvent  event,
+                                     BoltHistoryResult result,
+                                     guint32           duration,
+                                     GError          **error);
+
+GPtrArray *        bolt_history_query (BoltHistory *history,
+                                       const char  *uid,
+                                       guint64      since,
+                                       guint64      until,
+                                       guint        limit,
+                                       GError     **error);
+
+/* BoltHistoryEvent, BoltHistoryResult */
+const char *       bolt_history_event_to_string (BoltHistoryEvent event);
+
+const char *       bolt_history_result_to_string (BoltHistoryResult result);
+
+/* BoltHistoryEntry */
+void               bolt_history_entry_free (BoltHistoryEntry *entry);
+
+G_END_DECLS
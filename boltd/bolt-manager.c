@@ -21,12 +21,15 @@
 #include "config.h"
 
 #include "bolt-bouncer.h"
+#include "bolt-clock.h"
 #include "bolt-config.h"
 #include "bolt-device.h"
 #include "bolt-domain.h"
 #include "bolt-error.h"
+#include "bolt-io.h"
 #include "bolt-log.h"
 #include "bolt-power.h"
+#include "bolt-rules.h"
 #include "bolt-store.h"
 #include "bolt-str.h"
 #include "bolt-sysfs.h"
@@ -35,11 +38,29 @@
 
 #include "bolt-manager.h"
 
+#include <errno.h>
 #include <libudev.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #define MSEC_PER_USEC 1000LL
-#define PROBING_SETTLE_TIME_MS 2000 /* in milli-seconds */
+#define PROBING_SETTLE_TIME_MS 2000 /* in milli-seconds, upper bound */
+#define PROBING_SETTLE_MIN_MS 100   /* in milli-seconds, lower bound */
+#define PROBING_SETTLE_MARGIN 2     /* safety factor for learned gaps */
+#define PROBING_GAP_BUCKETS 12      /* log2 ms buckets, up to 4096 ms */
+#define PROBING_GAP_SAMPLES 8       /* gaps needed before we trust them */
+#define PROBING_GAP_PERCENTILE 95
+#define COALESCE_WINDOW_MS 25 /* in milli-seconds */
+#define POWER_WAIT_TIME_MS 5000 /* in milli-seconds */
+#define SNAPSHOT_FILENAME "manager.snapshot"
+#define HISTORY_FILENAME "history"
+#define SNAPSHOT_VERSION 1
+
+/* hotplug storm detection */
+#define STORM_WINDOW_MS 250 /* in milli-seconds */
+#define STORM_THRESHOLD 32  /* events per window to enter batch mode */
+#define STORM_BATCH_MS 100  /* in milli-seconds */
+#define STORM_BATCH_MIN (STORM_THRESHOLD * STORM_BATCH_MS / STORM_WINDOW_MS)
 
 typedef struct udev_device udev_device;
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (udev_device, udev_device_unref);
@@ -55,6 +76,21 @@ static gboolean bolt_manager_initialize (GInitable    *initable,
 /* internal manager functions */
 static void          manager_sd_notify_status (BoltManager *mgr);
 
+static void          manager_enumerate_devices (BoltManager *mgr);
+
+static void          manager_report_memory (BoltManager *mgr);
+
+/* warm restart */
+static void          manager_snapshot_load (BoltManager *mgr);
+
+static BoltDevice *  manager_snapshot_restore (BoltManager *mgr,
+                                               const char  *group,
+                                               BoltDomain  *domain);
+
+static BoltDevice *  manager_snapshot_lookup (BoltManager        *mgr,
+                                              struct udev_device *udev,
+                                              BoltDomain         *domain);
+
 /* domain related functions */
 static gboolean      manager_load_domains (BoltManager *mgr,
                                            GError     **error);
@@ -100,11 +136,40 @@ static GPtrArray *   bolt_manager_get_children (BoltManager *mgr,
 static void          bolt_manager_label_device (BoltManager *mgr,
                                                 BoltDevice  *target);
 
+static void          manager_topology_link (BoltManager *mgr,
+                                            BoltDevice  *dev);
+
+static void          manager_topology_unlink_parent (BoltManager *mgr,
+                                                     BoltDevice  *dev);
+
+static void          manager_topology_set_parent (BoltManager *mgr,
+                                                  BoltDevice  *dev,
+                                                  BoltDevice  *parent);
+
+static void          manager_topology_adopt_children (BoltManager *mgr,
+                                                      BoltDevice  *dev);
+
+static void          manager_topology_wait (BoltManager *mgr,
+                                            BoltDevice  *dev);
+
+static void          manager_topology_unwait (BoltManager *mgr,
+                                              BoltDevice  *dev);
+
+static void          manager_topology_unlink (BoltManager *mgr,
+                                              BoltDevice  *dev);
+
 /* udev events */
-static void         handle_uevent_udev (BoltUdev           *udev,
-                                        const char         *action,
-                                        struct udev_device *device,
-                                        gpointer            user_data);
+static void         handle_uevent_batch_udev (BoltUdev  *udev,
+                                              GPtrArray *batch,
+                                              gpointer   user_data);
+
+static void          manager_handle_uevent (BoltManager        *mgr,
+                                            const char         *action,
+                                            struct udev_device *device);
+
+static gboolean      manager_storm_check (BoltManager *mgr);
+
+static void          queued_event_free (gpointer data);
 
 static void          handle_udev_domain_event (BoltManager        *mgr,
                                                struct udev_device *device,
@@ -121,6 +186,34 @@ static void          handle_udev_device_added (BoltManager        *mgr,
                                                BoltDomain         *domain,
                                                struct udev_device *udev);
 
+static void          manager_coalesce_change (BoltManager        *mgr,
+                                              struct udev_device *device);
+
+static void          manager_coalesce_flush (BoltManager *mgr);
+
+static void          manager_coalesce_cancel (BoltManager *mgr);
+
+static void          handle_device_added (BoltManager *mgr,
+                                          BoltDevice  *dev);
+
+/* deferred, low priority work */
+typedef void (*DeferredFunc) (BoltManager *mgr,
+                              BoltDevice  *dev);
+
+static void          manager_defer (BoltManager *mgr,
+                                    BoltDevice  *dev,
+                                    DeferredFunc func);
+
+static void          deferred_device_export (BoltManager *mgr,
+                                             BoltDevice  *dev);
+
+static void          manager_maybe_authorize_new_device (BoltManager *mgr,
+                                                         BoltDevice  *dev);
+
+static void          deferred_job_free (gpointer data);
+
+static void          manager_deferred_flush (BoltManager *mgr);
+
 static void          handle_udev_device_changed (BoltManager        *mgr,
                                                  BoltDevice         *dev,
                                                  struct udev_device *udev);
@@ -153,6 +246,14 @@ static void          handle_device_status_changed (BoltDevice  *dev,
                                                    BoltStatus   old,
                                                    BoltManager *mgr);
 
+static void          handle_device_syspath_changed (BoltManager *mgr,
+                                                    GParamSpec  *unused,
+                                                    BoltDevice  *dev);
+
+static void          handle_domain_syspath_changed (BoltManager *mgr,
+                                                    GParamSpec  *unused,
+                                                    BoltDomain  *domain);
+
 static void          handle_power_state_changed (GObject    *gobject,
                                                  GParamSpec *pspec,
                                                  gpointer    user_data);
@@ -173,9 +274,53 @@ static void          manager_probing_activity (BoltManager *mgr,
 /* force powering */
 static BoltPowerGuard *  manager_maybe_power_controller (BoltManager *mgr);
 
+static void              manager_power_wait_done (BoltManager *mgr,
+                                                  const char  *reason);
+
+static gboolean          power_wait_timeout (gpointer user_data);
+
+/* device event history */
+static void          manager_history_open (BoltManager *mgr);
+
+static void          manager_history_put (BoltManager      *mgr,
+                                          const char       *uid,
+                                          BoltHistoryEvent  event,
+                                          BoltHistoryResult result,
+                                          guint32           duration);
+
+static void          manager_history_connect (BoltManager *mgr,
+                                              BoltDevice  *dev);
+
+static void          manager_history_status (BoltManager *mgr,
+                                             BoltDevice  *dev,
+                                             BoltStatus   old,
+                                             BoltStatus   now);
+
+/* idle exit */
+typedef struct IdleActivity IdleActivity;
+
+static IdleActivity * idle_activity_new (void);
+
+static IdleActivity * idle_activity_ref (IdleActivity *activity);
+
+static void          idle_activity_unref (gpointer data);
+
+static void          manager_idle_start (BoltManager *mgr);
+
+static void          manager_idle_stop (BoltManager *mgr);
+
 /* config */
 static void          manager_load_user_config (BoltManager *mgr);
 
+static void          manager_load_rules (BoltManager *mgr);
+
+static BoltRuleAction manager_rules_match (BoltManager *mgr,
+                                           BoltDevice  *dev,
+                                           const char **label);
+
+static void          manager_rules_apply (BoltManager *mgr,
+                                          BoltDevice  *dev);
+
 /* dbus property setter */
 static gboolean handle_set_authmode (BoltExported *obj,
                                      const char   *name,
@@ -208,11 +353,40 @@ static GVariant *  handle_enroll_device (BoltExported          *object,
                                          GDBusMethodInvocation *invocation,
                                          GError               **error);
 
+static GVariant *  handle_query_devices (BoltExported          *object,
+                                         GVariant              *params,
+                                         GDBusMethodInvocation *invocation,
+                                         GError               **error);
+
+static GVariant *  handle_get_history (BoltExported          *object,
+                                       GVariant              *params,
+                                       GDBusMethodInvocation *invocation,
+                                       GError               **error);
+
 static GVariant *  handle_forget_device (BoltExported          *object,
                                          GVariant              *params,
                                          GDBusMethodInvocation *invocation,
                                          GError               **error);
 
+/* path component trie for the probing roots; the activity
+ * statistics are kept when a root goes away, since it will
+ * most likely come back at the very same place */
+typedef struct ProbingNode
+{
+  GHashTable *children;  /* component -> ProbingNode */
+  gboolean    is_root;
+
+  /* activity behind this root */
+  guint64     events;                     /* number of events */
+  gint64      last;                       /* time stamp of the last one */
+  guint       gaps[PROBING_GAP_BUCKETS];  /* histogram of the gaps */
+  guint       ngaps;                      /* number of gaps recorded */
+} ProbingNode;
+
+static ProbingNode * probing_node_new (void);
+
+static void          probing_node_free (gpointer data);
+
 /*  */
 struct _BoltManager
 {
@@ -221,32 +395,107 @@ struct _BoltManager
   /* udev */
   BoltUdev *udev;
 
+  /* source of time and timeouts */
+  BoltClock *clock;
+
   /* state */
   BoltStore   *store;
   BoltDomain  *domains;
   GPtrArray   *devices;
   BoltPower   *power;
+
+  /* startup force-power */
+  BoltPowerGuard *power_guard; /* held until a domain appears */
+  guint           power_wait;  /* timeout source id */
+
+  /* warm restart state, only valid during startup */
+  GKeyFile       *snapshot;
+  guint           snapshot_hits;
+  gboolean        snapshot_quiet; /* no uevents since it was saved */
+
+  /* lookup indices */
+  GHashTable  *uid_index;       /* uid -> device */
+  GHashTable  *sysfs_index;     /* syspath -> device */
+  GHashTable  *sysfs_keys;      /* device -> key in sysfs_index */
+  GHashTable  *domain_index;    /* syspath -> domain */
+  GHashTable  *domain_keys;     /* domain -> key in domain_index */
+  GHashTable  *label_index;     /* "vendor\nname" -> count */
+  GHashTable  *status_index;    /* status -> set of devices */
+
+  /* immutable "ao" of all exported devices, NULL if stale */
+  GVariant    *devlist;
+
+  /* device topology */
+  GHashTable  *topo_parent;     /* device -> parent device */
+  GHashTable  *topo_children;   /* device -> GPtrArray of children */
+  GHashTable  *topo_waiting;    /* parent uid -> GPtrArray of children */
+  GHashTable  *topo_wait_keys;  /* device -> key in topo_waiting */
+
   BoltSecurity security;
   BoltAuthMode authmode;
 
   /* policy enforcer */
   BoltBouncer *bouncer;
 
+  /* device event history */
+  BoltHistory *history;       /* may be NULL */
+  GHashTable  *auth_start;    /* device -> start of authorization */
+
   /* config */
   GKeyFile  *config;
   BoltPolicy policy;          /* default enrollment policy, unless specified */
+  BoltRules *rules;           /* device policy rules, may be NULL */
 
   /* probing indicator  */
   guint      authorizing;     /* number of devices currently authorizing */
-  GPtrArray *probing_roots;   /* pci device tree root */
+  ProbingNode *probing_roots; /* trie of pci device tree roots */
   guint      probing_timeout; /* signal id & indicator */
   gint64     probing_tstamp;  /* time stamp of last activity */
   guint      probing_tsettle; /* how long to indicate after the last activity */
+  guint64    probing_events;  /* events seen in the current probing period */
+
+  /* deferred bookkeeping, see manager_defer () */
+  GQueue      deferred;
+  guint       deferred_source;
+
+  /* hotplug storm detection & batch mode */
+  gint64      storm_wstart;     /* start of the current rate window */
+  guint       storm_wcount;     /* events seen in the current window */
+  GQueue      storm_queue;      /* uevents queued in batch mode */
+  guint       storm_source;     /* batch timeout & batch mode indicator */
+  gint64      storm_start;      /* time stamp when batch mode started */
+  guint64     storm_events;     /* events handled in the current storm */
+  gint64      storm_busy;       /* processing time of the current storm */
+  guint       storm_count;      /* number of storms since startup */
+
+  /* uevent coalescing */
+  GPtrArray  *coalesce_queue;   /* pending 'change' events, in order */
+  GHashTable *coalesce_index;   /* syspath -> position in queue + 1 */
+  guint       coalesce_source;  /* flush timeout or idle source */
+  gboolean    coalesce_idle;    /* coalesce_source is an idle source */
+  guint       coalesce_window;  /* in ms, 0 means flush when idle */
+  guint       coalesce_batch;   /* merged events in the current batch */
+  guint64     coalesce_merged;  /* total number of merged events */
+
+  /* uevent source */
+  const char *uevent_source;    /* monitor name, NULL means auto */
+
+  /* idle exit */
+  guint       idle_timeout;     /* in seconds, 0 means disabled */
+  guint       idle_source;      /* periodic idle check */
+  guint       idle_filter;      /* dbus message filter id */
+  IdleActivity *idle_activity;  /* method calls & uevents */
+  gint        idle_seen;        /* activity at the last check */
 };
 
 enum {
   PROP_0,
 
+  /* internal properties */
+  PROP_CLOCK,
+  PROP_COALESCED,
+
+  /* exported properties */
   PROP_VERSION,
   PROP_PROBING,
   PROP_POLICY,
@@ -260,6 +509,13 @@ enum {
 
 static GParamSpec *props[PROP_LAST] = {NULL, };
 
+enum {
+  SIGNAL_IDLE,
+  SIGNAL_LAST
+};
+
+static guint signals[SIGNAL_LAST] = {0};
+
 G_DEFINE_TYPE_WITH_CODE (BoltManager,
                          bolt_manager,
                          BOLT_TYPE_EXPORTED,
@@ -276,18 +532,68 @@ bolt_manager_finalize (GObject *object)
 
   if (mgr->probing_timeout)
     {
-      g_source_remove (mgr->probing_timeout);
+      bolt_clock_source_remove (mgr->clock, mgr->probing_timeout);
       mgr->probing_timeout = 0;
     }
 
-  g_clear_pointer (&mgr->probing_roots, g_ptr_array_unref);
+  g_clear_pointer (&mgr->probing_roots, probing_node_free);
 
+  manager_coalesce_cancel (mgr);
+
+  if (mgr->power_wait)
+    {
+      bolt_clock_source_remove (mgr->clock, mgr->power_wait);
+      mgr->power_wait = 0;
+    }
+
+  g_clear_object (&mgr->power_guard);
+
+  if (mgr->deferred_source)
+    {
+      g_source_remove (mgr->deferred_source);
+      mgr->deferred_source = 0;
+    }
+
+  g_queue_clear_full (&mgr->deferred, deferred_job_free);
+
+  if (mgr->storm_source)
+    {
+      bolt_clock_source_remove (mgr->clock, mgr->storm_source);
+      mgr->storm_source = 0;
+    }
+
+  g_queue_clear_full (&mgr->storm_queue, queued_event_free);
+
+  g_clear_pointer (&mgr->coalesce_queue, g_ptr_array_unref);
+  g_clear_pointer (&mgr->coalesce_index, g_hash_table_unref);
+
+  manager_idle_stop (mgr);
+  g_clear_pointer (&mgr->idle_activity, idle_activity_unref);
+
+  g_clear_object (&mgr->rules);
+  g_clear_object (&mgr->history);
+  g_clear_pointer (&mgr->auth_start, g_hash_table_unref);
   g_clear_object (&mgr->store);
   g_ptr_array_free (mgr->devices, TRUE);
   bolt_domain_clear (&mgr->domains);
 
+  g_clear_pointer (&mgr->uid_index, g_hash_table_unref);
+  g_clear_pointer (&mgr->sysfs_keys, g_hash_table_unref);
+  g_clear_pointer (&mgr->sysfs_index, g_hash_table_unref);
+  g_clear_pointer (&mgr->domain_keys, g_hash_table_unref);
+  g_clear_pointer (&mgr->domain_index, g_hash_table_unref);
+  g_clear_pointer (&mgr->label_index, g_hash_table_unref);
+  g_clear_pointer (&mgr->status_index, g_hash_table_unref);
+  g_clear_pointer (&mgr->devlist, g_variant_unref);
+  g_clear_pointer (&mgr->topo_parent, g_hash_table_unref);
+  g_clear_pointer (&mgr->topo_children, g_hash_table_unref);
+  g_clear_pointer (&mgr->topo_wait_keys, g_hash_table_unref);
+  g_clear_pointer (&mgr->topo_waiting, g_hash_table_unref);
+
+  g_clear_pointer (&mgr->snapshot, g_key_file_unref);
   g_clear_object (&mgr->power);
   g_clear_object (&mgr->bouncer);
+  g_clear_object (&mgr->clock);
 
   G_OBJECT_CLASS (bolt_manager_parent_class)->finalize (object);
 }
@@ -327,6 +633,34 @@ bolt_manager_get_property (GObject    *object,
       g_value_set_enum (value, bolt_power_get_state (mgr->power));
       break;
 
+    case PROP_CLOCK:
+      g_value_set_object (value, mgr->clock);
+      break;
+
+    case PROP_COALESCED:
+      g_value_set_uint64 (value, mgr->coalesce_merged);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+bolt_manager_set_property (GObject      *object,
+                           guint         prop_id,
+                           const GValue *value,
+                           GParamSpec   *pspec)
+{
+  BoltManager *mgr = BOLT_MANAGER (object);
+
+  switch (prop_id)
+    {
+    case PROP_CLOCK:
+      if (g_value_get_object (value) != NULL)
+        g_set_object (&mgr->clock, g_value_get_object (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -336,11 +670,50 @@ static void
 bolt_manager_init (BoltManager *mgr)
 {
   mgr->devices = g_ptr_array_new_with_free_func (g_object_unref);
+  mgr->clock = g_object_ref (bolt_clock_get_default ());
+  mgr->idle_activity = idle_activity_new ();
+  mgr->auth_start = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL, g_free);
+
+  mgr->uid_index = g_hash_table_new (g_str_hash, g_str_equal);
+  /* keys are pooled, i.e. shared with the objects */
+  mgr->sysfs_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            (GDestroyNotify) bolt_str_pool_unref,
+                                            NULL);
+  mgr->sysfs_keys = g_hash_table_new (g_direct_hash, g_direct_equal);
+  mgr->domain_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             (GDestroyNotify) bolt_str_pool_unref,
+                                             NULL);
+  mgr->domain_keys = g_hash_table_new (g_direct_hash, g_direct_equal);
+  mgr->label_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free, NULL);
+  mgr->status_index = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL, (GDestroyNotify) g_hash_table_unref);
+
+  mgr->topo_parent = g_hash_table_new (g_direct_hash, g_direct_equal);
+  mgr->topo_children = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              NULL, (GDestroyNotify) g_ptr_array_unref);
+  mgr->topo_waiting = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, (GDestroyNotify) g_ptr_array_unref);
+  mgr->topo_wait_keys = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   mgr->store = bolt_store_new (g_getenv ("BOLT_DBPATH") ? : BOLT_DBDIR);
 
-  mgr->probing_roots = g_ptr_array_new_with_free_func (g_free);
+  /* tells clients to re-read everything after signals were dropped */
+  bolt_exported_set_resync_signal (BOLT_EXPORTED (mgr), "Resync");
+
+  mgr->probing_roots = probing_node_new ();
   mgr->probing_tsettle = PROBING_SETTLE_TIME_MS; /* milliseconds */
 
+  mgr->coalesce_queue = g_ptr_array_new_with_free_func ((GDestroyNotify) udev_device_unref);
+  mgr->coalesce_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, NULL);
+  mgr->coalesce_window = COALESCE_WINDOW_MS;
+  mgr->uevent_source = BOLT_UDEV_SOURCE_UDEV;
+
+  g_queue_init (&mgr->deferred);
+  g_queue_init (&mgr->storm_queue);
+
   mgr->security = BOLT_SECURITY_UNKNOWN;
 
   /* default configuration */
@@ -364,6 +737,24 @@ bolt_manager_class_init (BoltManagerClass *klass)
 
   gobject_class->finalize = bolt_manager_finalize;
   gobject_class->get_property = bolt_manager_get_property;
+  gobject_class->set_property = bolt_manager_set_property;
+
+  props[PROP_CLOCK] =
+    g_param_spec_object ("clock",
+                         NULL, NULL,
+                         BOLT_TYPE_CLOCK,
+                         G_PARAM_READWRITE |
+                         G_PARAM_CONSTRUCT_ONLY |
+                         G_PARAM_STATIC_STRINGS);
+
+  /* total number of change uevents that were merged into
+   * a newer one for the same device, see "ChangeCoalesceWindow" */
+  props[PROP_COALESCED] =
+    g_param_spec_uint64 ("coalesced-changes",
+                         NULL, NULL,
+                         0, G_MAXUINT64, 0,
+                         G_PARAM_READABLE |
+                         G_PARAM_STATIC_STRINGS);
 
   props[PROP_VERSION] =
     g_param_spec_uint ("version", "Version", "Version",
@@ -441,9 +832,27 @@ bolt_manager_class_init (BoltManagerClass *klass)
                                      "EnrollDevice",
                                      handle_enroll_device);
 
+  bolt_exported_class_export_method (exported_class,
+                                     "QueryDevices",
+                                     handle_query_devices);
+
   bolt_exported_class_export_method (exported_class,
                                      "ForgetDevice",
                                      handle_forget_device);
+
+  bolt_exported_class_export_method (exported_class,
+                                     "GetHistory",
+                                     handle_get_history);
+
+  signals[SIGNAL_IDLE] =
+    g_signal_new ("idle",
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,
+                  0);
 }
 
 static void
@@ -457,16 +866,16 @@ bolt_manager_initialize (GInitable    *initable,
                          GCancellable *cancellable,
                          GError      **error)
 {
-  g_autoptr(BoltPowerGuard) power = NULL;
+  const char *udev_filter[] = {"thunderbolt", "pci", "wmi", NULL};
   BoltManager *mgr;
-  struct udev_enumerate *enumerate;
-  struct udev_list_entry *l, *devices;
   gboolean ok;
 
   mgr = BOLT_MANAGER (initable);
 
   /* load dynamic user configuration */
   manager_load_user_config (mgr);
+  manager_load_rules (mgr);
+  manager_history_open (mgr);
 
   /* polkit setup */
   mgr->bouncer = bolt_bouncer_new (cancellable, error);
@@ -475,15 +884,26 @@ bolt_manager_initialize (GInitable    *initable,
 
   bolt_bouncer_add_client (mgr->bouncer, mgr);
 
-  /* udev setup*/
-  bolt_info (LOG_TOPIC ("udev"), "initializing udev");
-  mgr->udev = bolt_udev_new ("udev", NULL, error);
+  /* udev setup, restricted to the subsystems we care about:
+   * thunderbolt for the devices and domains, pci for the
+   * probing indicator and wmi for force power; for events
+   * re-broadcast by udevd the filter is installed in the
+   * kernel, so we do not even wake up for other events.
+   * Kernel uevents skip the udevd queue, which cuts down
+   * the authorization latency, but they are filtered in
+   * userspace, by libudev */
+  if (mgr->uevent_source == NULL)
+    mgr->uevent_source = bolt_udev_default_source ();
+
+  bolt_info (LOG_TOPIC ("udev"), "initializing udev (source: %s)",
+             mgr->uevent_source);
+  mgr->udev = bolt_udev_new (mgr->uevent_source, udev_filter, error);
 
   if (mgr->udev == NULL)
     return FALSE;
 
-  g_signal_connect_object (mgr->udev, "uevent",
-                           (GCallback) handle_uevent_udev,
+  g_signal_connect_object (mgr->udev, "uevent-batch",
+                           (GCallback) handle_uevent_batch_udev,
                            mgr, 0);
 
   ok = manager_load_domains (mgr, error);
@@ -495,181 +915,843 @@ bolt_manager_initialize (GInitable    *initable,
     return FALSE;
 
   /* setup the power controller */
-  mgr->power = bolt_power_new (mgr->udev);
+  mgr->power = bolt_power_new (mgr->udev, mgr->clock,
+                               g_getenv ("BOLT_RUNDIR"));
   bolt_bouncer_add_client (mgr->bouncer, mgr->power);
 
   g_signal_connect_object (mgr->power, "notify::state",
                            G_CALLBACK (handle_power_state_changed),
                            mgr, 0);
 
-  /* if we don't see any tb device, we try to force power */
-  power = manager_maybe_power_controller (mgr);
+  /* if we don't see any tb device, we try to force power; we
+   * do not wait for the domain here, but the guard is held until
+   * the domain shows up via udev or the wait times out */
+  mgr->power_guard = manager_maybe_power_controller (mgr);
 
-  if (power != NULL)
+  if (mgr->power_guard != NULL)
     bolt_info (LOG_TOPIC ("manager"), "acquired power guard '%s'",
-               bolt_power_guard_get_id (power));
+               bolt_power_guard_get_id (mgr->power_guard));
 
-  /* TODO: error checking */
-  enumerate =  bolt_udev_new_enumerate (mgr->udev, NULL);
-  udev_enumerate_add_match_subsystem (enumerate, "thunderbolt");
-  /* only devices (i.e. not the domain controller) */
+  /* state left behind by the previous instance, if it was
+   * shut down cleanly; used during enumeration to skip the
+   * sysfs reads for devices that did not change */
+  manager_snapshot_load (mgr);
 
-  bolt_info (LOG_TOPIC ("udev"), "enumerating devices");
-  udev_enumerate_scan_devices (enumerate);
-  devices = udev_enumerate_get_list_entry (enumerate);
+  manager_enumerate_devices (mgr);
 
-  udev_list_entry_foreach (l, devices)
+  if (mgr->snapshot != NULL)
     {
-      g_autoptr(GError) err = NULL;
-      g_autoptr(udev_device) udevice = NULL;
-      const char *syspath;
-      const char *devtype;
+      bolt_info (LOG_TOPIC ("snapshot"), "restored %u devices",
+                 mgr->snapshot_hits);
+      g_clear_pointer (&mgr->snapshot, g_key_file_unref);
+    }
 
-      syspath = udev_list_entry_get_name (l);
-      udevice = bolt_udev_device_new_from_syspath (mgr->udev,
-                                                   syspath,
-                                                   &err);
+  manager_report_memory (mgr);
 
-      if (udevice == NULL)
-        {
-          bolt_warn_err (err, "enumerating devices");
-          continue;
-        }
+  manager_sd_notify_status (mgr);
 
-      devtype = udev_device_get_devtype (udevice);
+  return TRUE;
+}
 
-      if (bolt_streq (devtype, "thunderbolt_domain"))
-        handle_udev_domain_event (mgr, udevice, "add");
+/* internal functions */
 
-      if (!bolt_streq (devtype, "thunderbolt_device"))
-        continue;
+/* warm restart: on clean shutdown the state of all connected
+ * devices is written to the run directory; on the next start
+ * devices whose sysfs directory is still the very same one,
+ * identified via its inode and ctime, are re-created from
+ * that, instead of reading all their attributes again; if
+ * the kernel's uevent sequence number did not move at all
+ * every entry is still valid and even that check is skipped */
+static char *
+manager_snapshot_path (BoltManager *mgr)
+{
+  g_autofree char *rundir = NULL;
 
-      handle_udev_device_event (mgr, udevice, "add");
-    }
+  if (mgr->power == NULL)
+    return NULL;
 
-  udev_enumerate_unref (enumerate);
+  g_object_get (mgr->power, "rundir", &rundir, NULL);
 
-  manager_sd_notify_status (mgr);
+  if (rundir == NULL)
+    return NULL;
 
-  return TRUE;
+  return g_build_filename (rundir, SNAPSHOT_FILENAME, NULL);
 }
 
-/* internal functions */
-static void
-manager_sd_notify_status (BoltManager *mgr)
+static gboolean
+snapshot_stat_syspath (const char *syspath,
+                       guint64    *inode,
+                       guint64    *ctime_ns)
 {
-  g_autoptr(GError) err = NULL;
-  g_autofree char *status = NULL;
-  const char *pstate = NULL;
-  BoltPowerState power;
-  gboolean sent;
-  gboolean authorizing;
-  gboolean ok = FALSE;
+  struct stat st;
+  int r;
 
-  authorizing = bolt_flag_isset (mgr->authmode, BOLT_AUTH_ENABLED);
-  power = bolt_power_get_state (mgr->power);
-  pstate = bolt_enum_to_string (BOLT_TYPE_POWER_STATE, power, NULL);
+  r = stat (syspath, &st);
+  if (r != 0)
+    return FALSE;
 
-  status = g_strdup_printf ("STATUS=authmode: %s,"
-                            " force-power: %s",
-                            (authorizing ? "enabled" : "DISABLED"),
-                            (pstate ? : "unknown"));
+  *inode = (guint64) st.st_ino;
+  *ctime_ns = (guint64) st.st_ctim.tv_sec * G_GUINT64_CONSTANT (1000000000) +
+              (guint64) st.st_ctim.tv_nsec;
 
-  ok = bolt_sd_notify_literal (status, &sent, &err);
+  return TRUE;
+}
+
+/* the kernel's uevent sequence number is bumped for every
+ * uevent and reset on boot; not available on all systems,
+ * e.g. in the test environment */
+static gboolean
+snapshot_uevent_seqnum (guint64 *seqnum)
+{
+  g_autofree char *data = NULL;
+  char *end = NULL;
+  gboolean ok;
 
+  ok = g_file_get_contents ("/sys/kernel/uevent_seqnum", &data, NULL, NULL);
   if (!ok)
-    bolt_warn_err (err, LOG_TOPIC ("status"),
-                   "failed to send status");
-  else
-    bolt_debug (LOG_TOPIC ("status"), "%s [sent: %s]",
-                status, bolt_yesno (sent));
+    return FALSE;
+
+  errno = 0;
+  *seqnum = g_ascii_strtoull (data, &end, 10);
+
+  return errno == 0 && end != data;
 }
 
 static void
-manager_maybe_set_security (BoltManager *mgr,
-                            BoltSecurity security)
+manager_snapshot_load (BoltManager *mgr)
 {
-  /* update the security level, if it is not already
-  * set, but also ignore if security is 'unknown' */
+  g_autoptr(GKeyFile) kf = NULL;
+  g_autoptr(GError) err = NULL;
+  g_autofree char *path = NULL;
+  guint64 saved, seqnum;
+  gint version;
+  gboolean ok;
 
-  if (security == BOLT_SECURITY_UNKNOWN)
+  path = manager_snapshot_path (mgr);
+  if (path == NULL)
     return;
 
-  if (mgr->security == BOLT_SECURITY_UNKNOWN)
+  kf = g_key_file_new ();
+  ok = g_key_file_load_from_file (kf, path, G_KEY_FILE_NONE, &err);
+
+  if (!ok)
     {
-      bolt_info ("security level set to '%s'",
-                 bolt_security_to_string (security));
-      mgr->security = security;
-      g_object_notify_by_pspec (G_OBJECT (mgr),
-                                props[PROP_SECURITY]);
+      if (!bolt_err_notfound (err))
+        bolt_warn_err (err, LOG_TOPIC ("snapshot"),
+                       "could not load snapshot");
+      return;
     }
-  else if (mgr->security != security)
+
+  /* the snapshot is only ever good for one start */
+  ok = bolt_unlink (path, &err);
+  if (!ok)
     {
-      bolt_warn ("multiple security levels (%s vs %s)",
-                 bolt_security_to_string (mgr->security),
-                 bolt_security_to_string (security));
+      bolt_warn_err (err, LOG_TOPIC ("snapshot"),
+                     "could not remove snapshot, ignoring it");
+      return;
     }
-}
-
-/* domain related function */
-static gboolean
-manager_load_domains (BoltManager *mgr,
-                      GError     **error)
-{
-  g_auto(GStrv) ids = NULL;
 
-  ids = bolt_store_list_uids (mgr->store, "domains", error);
-  if (ids == NULL)
+  version = g_key_file_get_integer (kf, "snapshot", "version", NULL);
+  if (version != SNAPSHOT_VERSION)
     {
-      g_prefix_error (error, "failed to list domains in store: ");
-      return FALSE;
+      bolt_info (LOG_TOPIC ("snapshot"), "ignoring snapshot version %d",
+                 version);
+      return;
     }
 
-  bolt_info (LOG_TOPIC ("store"), "loading domains");
+  mgr->snapshot_quiet = FALSE;
+  saved = g_key_file_get_uint64 (kf, "snapshot", "uevent-seqnum", NULL);
 
-  for (guint i = 0; i < g_strv_length (ids); i++)
+  if (saved > 0 && snapshot_uevent_seqnum (&seqnum))
     {
-      g_autoptr(GError) err = NULL;
-      BoltDomain *dom = NULL;
-      const char *uid = ids[i];
-
-      bolt_info (LOG_TOPIC ("store"), LOG_DOM_UID (uid),
-                 "loading domain");
-
-      dom = bolt_store_get_domain (mgr->store, uid, &err);
-      if (dom == NULL)
+      if (seqnum < saved)
         {
-          bolt_warn_err (err, LOG_DOM_UID (uid), LOG_TOPIC ("store"),
-                         "failed to load domain", uid);
-          continue;
+          bolt_info (LOG_TOPIC ("snapshot"), "ignoring snapshot from "
+                     "a previous boot");
+          return;
         }
 
-      manager_register_domain (mgr, dom);
+      mgr->snapshot_quiet = seqnum == saved;
+      bolt_debug (LOG_TOPIC ("snapshot"), "%" G_GUINT64_FORMAT
+                  " uevents since snapshot", seqnum - saved);
     }
 
-  return TRUE;
+  bolt_info (LOG_TOPIC ("snapshot"), "loaded snapshot from %s", path);
+  mgr->snapshot = g_steal_pointer (&kf);
+  mgr->snapshot_hits = 0;
 }
 
-static void
-manager_bootacl_inital_sync (BoltManager *mgr,
-                             BoltDomain  *domain)
+static BoltDevice *
+manager_snapshot_restore (BoltManager *mgr,
+                          const char  *group,
+                          BoltDomain  *domain)
 {
   g_autoptr(GError) err = NULL;
-  g_auto(GStrv) acl = NULL;
-  gboolean ok;
-  guint n, empty;
+  BoltDevice *dev;
 
-  if (!bolt_domain_supports_bootacl (domain))
+  dev = bolt_device_new_from_snapshot (mgr->snapshot, group, domain, &err);
+  if (dev == NULL)
     {
-      bolt_info (LOG_TOPIC ("bootacl"), LOG_DOM (domain),
-                 "bootacl not supported, no sync");
-      return;
+      bolt_warn_err (err, LOG_TOPIC ("snapshot"), "invalid entry %s", group);
+      return NULL;
     }
 
-  acl = bolt_domain_dup_bootacl (domain);
-  g_assert (acl != NULL);
+  return dev;
+}
 
-  n = bolt_domain_bootacl_slots (domain, &empty);
+static BoltDevice *
+manager_snapshot_lookup (BoltManager        *mgr,
+                         struct udev_device *udev,
+                         BoltDomain         *domain)
+{
+  g_autofree char *group = NULL;
+  const char *syspath;
+  const char *authorized;
+  BoltDevice *dev;
+  BoltStatus status;
+  guint64 inode, ctime_ns;
+  gboolean ok;
+
+  if (mgr->snapshot == NULL)
+    return NULL;
+
+  syspath = udev_device_get_syspath (udev);
+  group = g_strdup_printf ("device %s", syspath);
+
+  if (!g_key_file_has_group (mgr->snapshot, group))
+    return NULL;
+
+  /* no uevent at all since the snapshot was saved, nothing
+   * could have been replugged or (de-)authorized */
+  if (mgr->snapshot_quiet)
+    {
+      dev = manager_snapshot_restore (mgr, group, domain);
+      if (dev != NULL)
+        mgr->snapshot_hits++;
+      return dev;
+    }
+
+  /* a replug creates a new sysfs directory, which means a new
+   * inode and a new ctime, i.e. a different device as far as
+   * we are concerned */
+  ok = snapshot_stat_syspath (syspath, &inode, &ctime_ns);
+  if (!ok ||
+      inode != g_key_file_get_uint64 (mgr->snapshot, group, "sysfs-inode", NULL) ||
+      ctime_ns != g_key_file_get_uint64 (mgr->snapshot, group, "sysfs-ctime", NULL))
+    {
+      bolt_debug (LOG_TOPIC ("snapshot"), "stale entry for %s", syspath);
+      return NULL;
+    }
+
+  dev = manager_snapshot_restore (mgr, group, domain);
+  if (dev == NULL)
+    return NULL;
+
+  /* authorizing does not touch the directory itself, so
+   * compare the one attribute that can change in place */
+  authorized = udev_device_get_sysattr_value (udev, "authorized");
+  status = bolt_device_get_status (dev);
+
+  if (authorized == NULL ||
+      bolt_status_is_authorized (status) != !bolt_streq (authorized, "0"))
+    {
+      bolt_debug (LOG_TOPIC ("snapshot"), "status changed for %s", syspath);
+      g_object_unref (dev);
+      return NULL;
+    }
+
+  mgr->snapshot_hits++;
+  return dev;
+}
+
+void
+bolt_manager_save_snapshot (BoltManager *mgr)
+{
+  g_autoptr(GKeyFile) kf = NULL;
+  g_autoptr(GError) err = NULL;
+  g_autofree char *path = NULL;
+  guint64 seqnum;
+  guint count = 0;
+  gboolean ok;
+
+  g_return_if_fail (BOLT_IS_MANAGER (mgr));
+
+  path = manager_snapshot_path (mgr);
+  if (path == NULL)
+    return;
+
+  /* make sure everything pending is reflected */
+  manager_coalesce_flush (mgr);
+  manager_deferred_flush (mgr);
+
+  kf = g_key_file_new ();
+  g_key_file_set_integer (kf, "snapshot", "version", SNAPSHOT_VERSION);
+
+  if (snapshot_uevent_seqnum (&seqnum))
+    g_key_file_set_uint64 (kf, "snapshot", "uevent-seqnum", seqnum);
+
+  for (guint i = 0; i < mgr->devices->len; i++)
+    {
+      BoltDevice *dev = g_ptr_array_index (mgr->devices, i);
+      g_autofree char *group = NULL;
+      const char *syspath;
+      guint64 inode, ctime_ns;
+
+      /* stored devices are re-loaded from the store anyway
+       * and thus only new, connected devices are saved */
+      if (bolt_device_get_stored (dev))
+        continue;
+
+      syspath = bolt_device_get_syspath (dev);
+      if (syspath == NULL)
+        continue;
+
+      ok = snapshot_stat_syspath (syspath, &inode, &ctime_ns);
+      if (!ok)
+        continue;
+
+      group = g_strdup_printf ("device %s", syspath);
+      bolt_device_save_snapshot (dev, kf, group);
+      g_key_file_set_uint64 (kf, group, "sysfs-inode", inode);
+      g_key_file_set_uint64 (kf, group, "sysfs-ctime", ctime_ns);
+      count++;
+    }
+
+  ok = g_key_file_save_to_file (kf, path, &err);
+  if (!ok)
+    {
+      bolt_warn_err (err, LOG_TOPIC ("snapshot"),
+                     "could not save snapshot");
+      return;
+    }
+
+  bolt_info (LOG_TOPIC ("snapshot"), "saved %u devices to %s",
+             count, path);
+
+  manager_report_memory (mgr);
+}
+
+/* work that is still outstanding for uevents that were
+ * already received, i.e. batched or coalesced events,
+ * deferred jobs and authorizations in flight; used by
+ * the replay tool to know when processing is done */
+gboolean
+bolt_manager_is_busy (BoltManager *mgr)
+{
+  g_return_val_if_fail (BOLT_IS_MANAGER (mgr), FALSE);
+
+  return !g_queue_is_empty (&mgr->storm_queue) ||
+         mgr->coalesce_queue->len > 0 ||
+         !g_queue_is_empty (&mgr->deferred) ||
+         mgr->authorizing > 0;
+}
+
+/* startup enumeration: the sysfs heavy part, i.e. creating
+ * new devices and reading the attributes of known ones, is
+ * done on a thread pool; registration happens afterwards on
+ * the main thread, parents before children.
+ * libudev objects must not be used from more than one thread
+ * at a time, so each worker creates its own udev context and
+ * device object ('probe') from the syspath of the entry */
+typedef struct ProbeEntry
+{
+  struct udev_device *udev;    /* main thread only */
+  char               *syspath;
+  struct udev        *ctx;     /* owned by the worker ... */
+  struct udev_device *probe;   /* ... until it is done */
+  BoltDomain         *domain;
+  BoltDevice         *known;   /* device already in the store */
+  BoltDevice         *dev;     /* newly created device */
+  GError             *error;
+  guint               depth;   /* number of path components */
+} ProbeEntry;
+
+static void
+probe_entry_free (gpointer data)
+{
+  ProbeEntry *entry = data;
+
+  udev_device_unref (entry->udev);
+  g_clear_pointer (&entry->probe, udev_device_unref);
+  g_clear_pointer (&entry->ctx, udev_unref);
+  g_free (entry->syspath);
+  g_clear_object (&entry->domain);
+  g_clear_object (&entry->known);
+  g_clear_object (&entry->dev);
+  g_clear_error (&entry->error);
+  g_slice_free (ProbeEntry, entry);
+}
+
+static gint
+probe_entry_compare (gconstpointer a,
+                     gconstpointer b)
+{
+  const ProbeEntry *ea = *(const ProbeEntry **) a;
+  const ProbeEntry *eb = *(const ProbeEntry **) b;
+
+  return (gint) ea->depth - (gint) eb->depth;
+}
+
+static void
+probe_entry_in_thread (gpointer data,
+                       gpointer user_data)
+{
+  ProbeEntry *entry = data;
+  BoltDevInfo info;
+
+  if (entry->known == NULL && entry->dev != NULL)
+    return; /* restored from the snapshot */
+
+  entry->ctx = udev_new ();
+  if (entry->ctx != NULL)
+    entry->probe = udev_device_new_from_syspath (entry->ctx, entry->syspath);
+
+  if (entry->probe == NULL)
+    {
+      g_set_error (&entry->error, BOLT_ERROR, BOLT_ERROR_UDEV,
+                   "could not create udev device: %s",
+                   g_strerror (errno));
+      return;
+    }
+
+  if (entry->known == NULL)
+    {
+      entry->dev = bolt_device_new_for_udev (entry->probe,
+                                             entry->domain,
+                                             &entry->error);
+      return;
+    }
+
+  /* the result is discarded, but the attribute values
+   * are now cached in the probe device object, where
+   * bolt_device_connected () will find them */
+  (void) bolt_sysfs_info_for_device (entry->probe, TRUE, &info, NULL);
+}
+
+static ProbeEntry *
+manager_probe_entry_new (BoltManager        *mgr,
+                         struct udev_device *udev)
+{
+  ProbeEntry *entry;
+  BoltDomain *dom;
+  const char *syspath;
+  const char *uid;
+
+  /* filter sysfs devices (e.g. the domain) that don't have
+   * the unique_id attribute */
+  uid = udev_device_get_sysattr_value (udev, "unique_id");
+  if (uid == NULL)
+    return NULL;
+
+  syspath = udev_device_get_syspath (udev);
+  dom = manager_domain_ensure (mgr, udev);
+
+  if (dom == NULL)
+    {
+      bolt_warn (LOG_TOPIC ("domain"),
+                 "could not find domain for device at '%s'",
+                 syspath);
+      return NULL;
+    }
+
+  entry = g_slice_new0 (ProbeEntry);
+  entry->udev = udev_device_ref (udev);
+  entry->syspath = g_strdup (syspath);
+  entry->domain = g_object_ref (dom);
+  entry->known = manager_find_device_by_uid (mgr, uid, NULL);
+
+  if (entry->known == NULL)
+    entry->dev = manager_snapshot_lookup (mgr, udev, dom);
+
+  for (const char *c = syspath; *c; c++)
+    if (*c == '/')
+      entry->depth++;
+
+  return entry;
+}
+
+static void
+manager_enumerate_devices (BoltManager *mgr)
+{
+  g_autoptr(GPtrArray) entries = NULL;
+  g_autoptr(GError) err = NULL;
+  struct udev_enumerate *enumerate;
+  struct udev_list_entry *l, *devices;
+  GThreadPool *pool;
+  gint64 start;
+  guint nthreads;
+  gboolean threaded;
+
+  /* TODO: error checking */
+  enumerate =  bolt_udev_new_enumerate (mgr->udev, NULL);
+  udev_enumerate_add_match_subsystem (enumerate, "thunderbolt");
+
+  bolt_info (LOG_TOPIC ("udev"), "enumerating devices");
+  udev_enumerate_scan_devices (enumerate);
+  devices = udev_enumerate_get_list_entry (enumerate);
+
+  start = g_get_monotonic_time ();
+  entries = g_ptr_array_new_with_free_func (probe_entry_free);
+
+  udev_list_entry_foreach (l, devices)
+    {
+      g_autoptr(udev_device) udevice = NULL;
+      ProbeEntry *entry;
+      const char *syspath;
+      const char *devtype;
+
+      syspath = udev_list_entry_get_name (l);
+      udevice = bolt_udev_device_new_from_syspath (mgr->udev,
+                                                   syspath,
+                                                   &err);
+
+      if (udevice == NULL)
+        {
+          bolt_warn_err (err, "enumerating devices");
+          g_clear_error (&err);
+          continue;
+        }
+
+      devtype = udev_device_get_devtype (udevice);
+
+      if (bolt_streq (devtype, "thunderbolt_domain"))
+        handle_udev_domain_event (mgr, udevice, "add");
+
+      /* only devices (i.e. not the domain controller) */
+      if (!bolt_streq (devtype, "thunderbolt_device"))
+        continue;
+
+      entry = manager_probe_entry_new (mgr, udevice);
+      if (entry != NULL)
+        g_ptr_array_add (entries, entry);
+    }
+
+  udev_enumerate_unref (enumerate);
+
+  if (entries->len == 0)
+    return;
+
+  nthreads = MIN (entries->len, g_get_num_processors ());
+  pool = g_thread_pool_new (probe_entry_in_thread, NULL,
+                            (gint) nthreads, TRUE, &err);
+
+  threaded = pool != NULL;
+
+  if (threaded)
+    {
+      for (guint i = 0; i < entries->len; i++)
+        g_thread_pool_push (pool, g_ptr_array_index (entries, i), NULL);
+
+      /* wait for all the entries to be processed */
+      g_thread_pool_free (pool, FALSE, TRUE);
+
+      bolt_info (LOG_TOPIC ("udev"), "probed %u devices with %u threads "
+                 "in %" G_GINT64_FORMAT " us", entries->len, nthreads,
+                 g_get_monotonic_time () - start);
+    }
+  else
+    {
+      bolt_warn_err (err, LOG_TOPIC ("udev"),
+                     "could not create thread pool, probing serially");
+    }
+
+  /* register, parents before children, so the topology
+   * and the authorization chain are in place for each
+   * device when it is added. D-Bus export of all of
+   * them happens in bolt_manager_export () */
+  g_ptr_array_sort (entries, probe_entry_compare);
+
+  for (guint i = 0; i < entries->len; i++)
+    {
+      ProbeEntry *entry = g_ptr_array_index (entries, i);
+
+      if (!threaded)
+        probe_entry_in_thread (entry, NULL);
+
+      if (entry->known != NULL)
+        {
+          /* the worker is done, so its probe device, with the
+           * cached attributes, can be used here now */
+          struct udev_device *udev = entry->probe ? : entry->udev;
+
+          if (bolt_device_is_connected (entry->known))
+            handle_udev_device_changed (mgr, entry->known, udev);
+          else
+            handle_udev_device_attached (mgr, entry->domain,
+                                         entry->known, udev);
+        }
+      else if (entry->dev != NULL)
+        {
+          handle_device_added (mgr, g_steal_pointer (&entry->dev));
+        }
+      else
+        {
+          bolt_warn_err (entry->error, LOG_TOPIC ("udev"),
+                         "could not create device");
+        }
+    }
+}
+
+/* the strings of all devices live in the shared pool, so
+ * the per device cost is the instance plus its share of
+ * the pool */
+static void
+manager_report_memory (BoltManager *mgr)
+{
+  BoltStrPoolStats stats;
+  GTypeQuery query;
+  guint n;
+  gsize per_dev;
+
+  n = mgr->devices->len;
+  g_type_query (BOLT_TYPE_DEVICE, &query);
+  bolt_str_pool_stats (&stats);
+
+  per_dev = query.instance_size;
+  if (n > 0)
+    per_dev += stats.bytes / n;
+
+  bolt_info (LOG_TOPIC ("memory"), "%u devices, ~%" G_GSIZE_FORMAT
+             " bytes each; string pool: %u strings, %u refs, %"
+             G_GSIZE_FORMAT " bytes, %" G_GSSIZE_FORMAT " bytes saved",
+             n, per_dev, stats.count, stats.refs, stats.bytes,
+             stats.saved);
+}
+
+static void
+manager_sd_notify_status (BoltManager *mgr)
+{
+  g_autoptr(GError) err = NULL;
+  g_autofree char *status = NULL;
+  const char *pstate = NULL;
+  BoltPowerState power;
+  gboolean sent;
+  gboolean authorizing;
+  gboolean ok = FALSE;
+
+  authorizing = bolt_flag_isset (mgr->authmode, BOLT_AUTH_ENABLED);
+  power = bolt_power_get_state (mgr->power);
+  pstate = bolt_enum_to_string (BOLT_TYPE_POWER_STATE, power, NULL);
+
+  status = g_strdup_printf ("STATUS=authmode: %s,"
+                            " force-power: %s",
+                            (authorizing ? "enabled" : "DISABLED"),
+                            (pstate ? : "unknown"));
+
+  ok = bolt_sd_notify_literal (status, &sent, &err);
+
+  if (!ok)
+    bolt_warn_err (err, LOG_TOPIC ("status"),
+                   "failed to send status");
+  else
+    bolt_debug (LOG_TOPIC ("status"), "%s [sent: %s]",
+                status, bolt_yesno (sent));
+}
+
+static void
+manager_maybe_set_security (BoltManager *mgr,
+                            BoltSecurity security)
+{
+  /* update the security level, if it is not already
+  * set, but also ignore if security is 'unknown' */
+
+  if (security == BOLT_SECURITY_UNKNOWN)
+    return;
+
+  if (mgr->security == BOLT_SECURITY_UNKNOWN)
+    {
+      bolt_info ("security level set to '%s'",
+                 bolt_security_to_string (security));
+      mgr->security = security;
+      g_object_notify_by_pspec (G_OBJECT (mgr),
+                                props[PROP_SECURITY]);
+    }
+  else if (mgr->security != security)
+    {
+      bolt_warn ("multiple security levels (%s vs %s)",
+                 bolt_security_to_string (mgr->security),
+                 bolt_security_to_string (security));
+    }
+}
+
+/* lookup indices */
+static void
+manager_index_set (GHashTable *index,
+                   GHashTable *keys,
+                   gpointer    object,
+                   const char *key)
+{
+  gpointer other;
+  const char *have;
+
+  /* 'index' owns the keys, 'keys' is the reverse
+   * mapping from the object to its current key */
+  have = g_hash_table_lookup (keys, object);
+
+  if (have != NULL && bolt_streq (have, key))
+    return;
+
+  if (have != NULL)
+    {
+      g_hash_table_remove (keys, object);
+      g_hash_table_remove (index, have);
+    }
+
+  if (key == NULL)
+    return;
+
+  other = g_hash_table_lookup (index, key);
+  if (other != NULL)
+    g_hash_table_remove (keys, other);
+
+  have = bolt_str_pool_ref (key);
+  g_hash_table_replace (index, (gpointer) have, object);
+  g_hash_table_insert (keys, object, (gpointer) have);
+}
+
+static char *
+manager_label_key (BoltDevice *dev)
+{
+  const char *name = bolt_device_get_name (dev);
+  const char *vendor = bolt_device_get_vendor (dev);
+
+  return g_strconcat (vendor ? : "", "\n", name ? : "", NULL);
+}
+
+static void
+manager_label_index_update (BoltManager *mgr,
+                            BoltDevice  *dev,
+                            gint         delta)
+{
+  g_autofree char *key = NULL;
+  gpointer val;
+  gint count;
+
+  key = manager_label_key (dev);
+  val = g_hash_table_lookup (mgr->label_index, key);
+  count = (gint) GPOINTER_TO_UINT (val) + delta;
+
+  if (count > 0)
+    g_hash_table_replace (mgr->label_index,
+                          g_steal_pointer (&key),
+                          GUINT_TO_POINTER (count));
+  else
+    g_hash_table_remove (mgr->label_index, key);
+}
+
+static guint
+manager_label_index_count (BoltManager *mgr,
+                           BoltDevice  *dev)
+{
+  g_autofree char *key = NULL;
+  gpointer val;
+
+  key = manager_label_key (dev);
+  val = g_hash_table_lookup (mgr->label_index, key);
+
+  return GPOINTER_TO_UINT (val);
+}
+
+static void
+manager_status_index_add (BoltManager *mgr,
+                          BoltDevice  *dev,
+                          BoltStatus   status)
+{
+  GHashTable *bucket;
+  gpointer key = GINT_TO_POINTER (status);
+
+  bucket = g_hash_table_lookup (mgr->status_index, key);
+
+  if (bucket == NULL)
+    {
+      bucket = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_hash_table_insert (mgr->status_index, key, bucket);
+    }
+
+  g_hash_table_add (bucket, dev);
+}
+
+static gboolean
+manager_status_index_remove (BoltManager *mgr,
+                             BoltDevice  *dev,
+                             BoltStatus   status)
+{
+  GHashTable *bucket;
+  gpointer key = GINT_TO_POINTER (status);
+  gboolean removed;
+
+  bucket = g_hash_table_lookup (mgr->status_index, key);
+
+  if (bucket == NULL)
+    return FALSE;
+
+  removed = g_hash_table_remove (bucket, dev);
+
+  if (g_hash_table_size (bucket) == 0)
+    g_hash_table_remove (mgr->status_index, key);
+
+  return removed;
+}
+
+/* domain related function */
+static gboolean
+manager_load_domains (BoltManager *mgr,
+                      GError     **error)
+{
+  g_auto(GStrv) ids = NULL;
+
+  ids = bolt_store_list_uids (mgr->store, "domains", error);
+  if (ids == NULL)
+    {
+      g_prefix_error (error, "failed to list domains in store: ");
+      return FALSE;
+    }
+
+  bolt_info (LOG_TOPIC ("store"), "loading domains");
+
+  for (guint i = 0; i < g_strv_length (ids); i++)
+    {
+      g_autoptr(GError) err = NULL;
+      BoltDomain *dom = NULL;
+      const char *uid = ids[i];
+
+      bolt_info (LOG_TOPIC ("store"), LOG_DOM_UID (uid),
+                 "loading domain");
+
+      dom = bolt_store_get_domain (mgr->store, uid, &err);
+      if (dom == NULL)
+        {
+          bolt_warn_err (err, LOG_DOM_UID (uid), LOG_TOPIC ("store"),
+                         "failed to load domain", uid);
+          continue;
+        }
+
+      manager_register_domain (mgr, dom);
+    }
+
+  return TRUE;
+}
+
+static void
+manager_bootacl_inital_sync (BoltManager *mgr,
+                             BoltDomain  *domain)
+{
+  g_autoptr(GError) err = NULL;
+  g_auto(GStrv) acl = NULL;
+  gboolean ok;
+  guint n, empty;
+
+  if (!bolt_domain_supports_bootacl (domain))
+    {
+      bolt_info (LOG_TOPIC ("bootacl"), LOG_DOM (domain),
+                 "bootacl not supported, no sync");
+      return;
+    }
+
+  acl = bolt_domain_dup_bootacl (domain);
+  g_assert (acl != NULL);
+
+  n = bolt_domain_bootacl_slots (domain, &empty);
 
   bolt_info (LOG_TOPIC ("bootacl"), LOG_DOM (domain),
              "sync start [slots: %u free: %u]", n, empty);
@@ -812,21 +1894,30 @@ static BoltDomain *
 manager_find_domain_by_syspath (BoltManager *mgr,
                                 const char  *syspath)
 {
-  BoltDomain *iter = mgr->domains;
-  guint n_domains;
+  g_autofree char *path = NULL;
+  BoltDomain *domain;
+  char *pos;
 
-  n_domains = bolt_domain_count (mgr->domains);
-  for (guint i = 0; i < n_domains; i++)
-    {
-      const char *prefix = bolt_domain_get_syspath (iter);
+  g_return_val_if_fail (syspath != NULL, NULL);
 
-      /* we get a perfect match, if we search for the domain
-       * itself, or if we are looking for the domain that
-       * is the parent of the device in @syspath */
-      if (prefix && g_str_has_prefix (syspath, prefix))
-        return iter;
+  /* we get a perfect match, if we search for the domain
+   * itself, otherwise we are looking for the domain that
+   * is the parent of the device in @syspath, which we
+   * find by walking up the path, one component at a time */
+  domain = g_hash_table_lookup (mgr->domain_index, syspath);
 
-      iter = bolt_domain_next (iter);
+  if (domain != NULL)
+    return domain;
+
+  path = g_strdup (syspath);
+
+  while ((pos = strrchr (path, '/')) != NULL && pos != path)
+    {
+      *pos = '\0';
+
+      domain = g_hash_table_lookup (mgr->domain_index, path);
+      if (domain != NULL)
+        return domain;
     }
 
   return NULL;
@@ -888,6 +1979,9 @@ manager_register_domain (BoltManager *mgr,
 
   mgr->domains = bolt_domain_insert (mgr->domains, domain);
 
+  manager_index_set (mgr->domain_index, mgr->domain_keys, domain,
+                     bolt_domain_get_syspath (domain));
+
   n_slots = bolt_domain_bootacl_slots (domain, &n_free);
 
   bolt_info (LOG_TOPIC ("domain"), LOG_DOM (domain),
@@ -900,6 +1994,10 @@ manager_register_domain (BoltManager *mgr,
   g_signal_connect_object (domain, "notify::security",
                            G_CALLBACK (handle_domain_security_changed),
                            mgr, G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (domain, "notify::syspath",
+                           G_CALLBACK (handle_domain_syspath_changed),
+                           mgr, G_CONNECT_SWAPPED);
 }
 
 static void
@@ -911,6 +2009,12 @@ manager_deregister_domain (BoltManager *mgr,
   name = bolt_domain_get_id (domain);
   bolt_info (LOG_TOPIC ("domain"), "'%s' removed", name);
 
+  g_signal_handlers_disconnect_by_func (domain,
+                                        handle_domain_syspath_changed,
+                                        mgr);
+
+  manager_index_set (mgr->domain_index, mgr->domain_keys, domain, NULL);
+
   mgr->domains = bolt_domain_remove (mgr->domains, domain);
 }
 
@@ -952,43 +2056,82 @@ manager_load_devices (BoltManager *mgr,
   return TRUE;
 }
 
+static void
+manager_devlist_invalidate (BoltManager *mgr)
+{
+  g_clear_pointer (&mgr->devlist, g_variant_unref);
+}
+
 static void
 manager_register_device (BoltManager *mgr,
                          BoltDevice  *dev)
 {
 
   g_ptr_array_add (mgr->devices, dev);
+  manager_devlist_invalidate (mgr);
+
+  g_hash_table_insert (mgr->uid_index,
+                       (gpointer) bolt_device_get_uid (dev),
+                       dev);
+
+  manager_index_set (mgr->sysfs_index, mgr->sysfs_keys, dev,
+                     bolt_device_get_syspath (dev));
+
+  manager_label_index_update (mgr, dev, 1);
+  manager_status_index_add (mgr, dev, bolt_device_get_status (dev));
+
   bolt_bouncer_add_client (mgr->bouncer, dev);
   g_signal_connect_object (dev, "status-changed",
                            G_CALLBACK (handle_device_status_changed),
                            mgr, 0);
+
+  g_signal_connect_object (dev, "notify::sysfs-path",
+                           G_CALLBACK (handle_device_syspath_changed),
+                           mgr, G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (dev, "notify::exported",
+                           G_CALLBACK (manager_devlist_invalidate),
+                           mgr, G_CONNECT_SWAPPED);
 }
 
 static void
 manager_deregister_device (BoltManager *mgr,
                            BoltDevice  *dev)
 {
+  g_signal_handlers_disconnect_by_func (dev,
+                                        handle_device_syspath_changed,
+                                        mgr);
+
+  g_signal_handlers_disconnect_by_func (dev,
+                                        manager_devlist_invalidate,
+                                        mgr);
+
+  manager_topology_unlink (mgr, dev);
+
+  g_hash_table_remove (mgr->uid_index, bolt_device_get_uid (dev));
+  manager_index_set (mgr->sysfs_index, mgr->sysfs_keys, dev, NULL);
+  manager_label_index_update (mgr, dev, -1);
+  manager_status_index_remove (mgr, dev, bolt_device_get_status (dev));
+  g_hash_table_remove (mgr->auth_start, dev);
+
   g_ptr_array_remove_fast (mgr->devices, dev);
+  manager_devlist_invalidate (mgr);
 }
 
 static BoltDevice *
 manager_find_device_by_syspath (BoltManager *mgr,
                                 const char  *sysfs)
 {
+  BoltDevice *dev;
 
   g_return_val_if_fail (sysfs != NULL, NULL);
 
-  for (guint i = 0; i < mgr->devices->len; i++)
-    {
-      BoltDevice *dev = g_ptr_array_index (mgr->devices, i);
-      const char *have = bolt_device_get_syspath (dev);
-
-      if (bolt_streq (have, sysfs))
-        return g_object_ref (dev);
+  dev = g_hash_table_lookup (mgr->sysfs_index, sysfs);
 
-    }
+  if (dev == NULL)
+    return NULL;
 
-  return NULL;
+  return g_object_ref (dev);
 }
 
 static BoltDevice *
@@ -996,6 +2139,8 @@ manager_find_device_by_uid (BoltManager *mgr,
                             const char  *uid,
                             GError     **error)
 {
+  BoltDevice *dev;
+
   if (uid == NULL || uid[0] == '\0')
     {
       g_set_error_literal (error, G_IO_ERROR,
@@ -1004,14 +2149,10 @@ manager_find_device_by_uid (BoltManager *mgr,
       return NULL;
     }
 
-  for (guint i = 0; i < mgr->devices->len; i++)
-    {
-      BoltDevice *dev = g_ptr_array_index (mgr->devices, i);
-
-      if (bolt_streq (bolt_device_get_uid (dev), uid))
-        return g_object_ref (dev);
+  dev = g_hash_table_lookup (mgr->uid_index, uid);
 
-    }
+  if (dev != NULL)
+    return g_object_ref (dev);
 
   g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
                "device with id '%s' could not be found.",
@@ -1021,48 +2162,271 @@ manager_find_device_by_uid (BoltManager *mgr,
 }
 
 
-static BoltDevice *
-bolt_manager_get_parent (BoltManager *mgr,
-                         BoltDevice  *dev)
+/* device topology */
+static void
+manager_topology_sync (BoltManager *mgr,
+                       BoltDevice  *dev)
+{
+  g_auto(GStrv) uids = NULL;
+  GPtrArray *children;
+  guint n = 0;
+
+  children = g_hash_table_lookup (mgr->topo_children, dev);
+
+  if (children != NULL)
+    n = children->len;
+
+  uids = g_new0 (char *, n + 1);
+
+  for (guint i = 0; i < n; i++)
+    {
+      BoltDevice *child = g_ptr_array_index (children, i);
+      uids[i] = g_strdup (bolt_device_get_uid (child));
+    }
+
+  g_object_set (dev, "children", uids, NULL);
+}
+
+static void
+manager_topology_link (BoltManager *mgr,
+                       BoltDevice  *dev)
 {
   g_autofree char *path = NULL;
+  BoltDevice *parent = NULL;
   const char *syspath;
   const char *start;
   char *pos;
 
   syspath = bolt_device_get_syspath (dev);
   if (syspath == NULL)
-    return NULL;
+    return;
 
+  /* the parent device is the one sysfs directory up */
   path = g_strdup (syspath);
   start = path + strlen ("/sys");
 
   pos = strrchr (start, '/');
-  if (!pos || pos < start + 2)
-    return NULL;
+  if (pos && pos >= start + 2)
+    {
+      *pos = '\0';
+      parent = g_hash_table_lookup (mgr->sysfs_index, path);
+    }
+
+  if (parent != NULL && parent != dev)
+    manager_topology_set_parent (mgr, dev, parent);
+  else
+    manager_topology_wait (mgr, dev);
+
+  /* the children might have been registered before us,
+   * e.g. when events are coalesced or during the parallel
+   * startup enumeration, or we moved to a new sysfs path */
+  manager_topology_adopt_children (mgr, dev);
+}
+
+static void
+manager_topology_set_parent (BoltManager *mgr,
+                             BoltDevice  *dev,
+                             BoltDevice  *parent)
+{
+  GPtrArray *children;
+
+  manager_topology_unwait (mgr, dev);
+
+  /* in case we are re-linked without being unlinked */
+  if (g_hash_table_lookup (mgr->topo_parent, dev) == parent)
+    return;
+
+  manager_topology_unlink_parent (mgr, dev);
+
+  g_hash_table_insert (mgr->topo_parent, dev, parent);
+
+  children = g_hash_table_lookup (mgr->topo_children, parent);
+  if (children == NULL)
+    {
+      children = g_ptr_array_new ();
+      g_hash_table_insert (mgr->topo_children, parent, children);
+    }
+
+  g_ptr_array_add (children, dev);
+
+  bolt_debug (LOG_DEV (dev), LOG_TOPIC ("topology"),
+              "linked to parent [%u children]",
+              children->len);
+
+  manager_topology_sync (mgr, parent);
+}
+
+static void
+manager_topology_adopt_children (BoltManager *mgr,
+                                 BoltDevice  *dev)
+{
+  g_autoptr(GPtrArray) children = NULL;
+  g_autofree char *key = NULL;
+  gpointer k, v;
+  gboolean found;
+
+  found = g_hash_table_lookup_extended (mgr->topo_waiting,
+                                        bolt_device_get_uid (dev),
+                                        &k, &v);
+  if (!found)
+    return;
+
+  /* take over the entry, since linking the children
+   * will modify the waiting index */
+  g_hash_table_steal (mgr->topo_waiting, k);
+  children = v;
+  key = k;
+
+  for (guint i = 0; i < children->len; i++)
+    {
+      BoltDevice *child = g_ptr_array_index (children, i);
+
+      g_hash_table_remove (mgr->topo_wait_keys, child);
+
+      if (child != dev)
+        manager_topology_set_parent (mgr, child, dev);
+    }
+}
+
+/* children whose parent is not (yet) known wait for it,
+ * indexed by the uid of the parent, see above */
+static void
+manager_topology_wait (BoltManager *mgr,
+                       BoltDevice  *dev)
+{
+  const char *uid;
+  gpointer key;
+  gpointer children;
+
+  uid = bolt_device_get_parent_uid (dev);
+  key = g_hash_table_lookup (mgr->topo_wait_keys, dev);
+
+  if (bolt_streq (key, uid))
+    return;
+
+  manager_topology_unwait (mgr, dev);
+
+  if (uid == NULL)
+    return;
+
+  if (!g_hash_table_lookup_extended (mgr->topo_waiting, uid, &key, &children))
+    {
+      key = g_strdup (uid);
+      children = g_ptr_array_new ();
+      g_hash_table_insert (mgr->topo_waiting, key, children);
+    }
+
+  g_ptr_array_add (children, dev);
+
+  /* the key is owned by the topo_waiting table */
+  g_hash_table_insert (mgr->topo_wait_keys, dev, key);
+}
+
+static void
+manager_topology_unwait (BoltManager *mgr,
+                         BoltDevice  *dev)
+{
+  GPtrArray *children;
+  const char *key;
+
+  key = g_hash_table_lookup (mgr->topo_wait_keys, dev);
 
-  *pos = '\0';
+  if (key == NULL)
+    return;
+
+  g_hash_table_remove (mgr->topo_wait_keys, dev);
+
+  children = g_hash_table_lookup (mgr->topo_waiting, key);
+  if (children != NULL)
+    g_ptr_array_remove_fast (children, dev);
+
+  /* frees the key, but only if nobody else waits */
+  if (children != NULL && children->len == 0)
+    g_hash_table_remove (mgr->topo_waiting, key);
+}
+
+static void
+manager_topology_unlink_parent (BoltManager *mgr,
+                                BoltDevice  *dev)
+{
+  BoltDevice *parent;
+  GPtrArray *children;
+
+  parent = g_hash_table_lookup (mgr->topo_parent, dev);
+
+  if (parent == NULL)
+    return;
+
+  g_hash_table_remove (mgr->topo_parent, dev);
+
+  children = g_hash_table_lookup (mgr->topo_children, parent);
+  if (children != NULL)
+    g_ptr_array_remove_fast (children, dev);
+
+  if (children != NULL && children->len == 0)
+    g_hash_table_remove (mgr->topo_children, parent);
+
+  manager_topology_sync (mgr, parent);
+}
+
+static void
+manager_topology_unlink (BoltManager *mgr,
+                         BoltDevice  *dev)
+{
+  GPtrArray *children;
+
+  manager_topology_unwait (mgr, dev);
+  manager_topology_unlink_parent (mgr, dev);
+
+  /* the children of the device become orphans and wait
+   * for it to come back; normally they are gone already,
+   * since the kernel removes the children before the parent */
+  children = g_hash_table_lookup (mgr->topo_children, dev);
+
+  if (children == NULL)
+    return;
+
+  for (guint i = 0; i < children->len; i++)
+    {
+      BoltDevice *child = g_ptr_array_index (children, i);
+      g_hash_table_remove (mgr->topo_parent, child);
+      manager_topology_wait (mgr, child);
+    }
+
+  g_hash_table_remove (mgr->topo_children, dev);
+  manager_topology_sync (mgr, dev);
+}
+
+static BoltDevice *
+bolt_manager_get_parent (BoltManager *mgr,
+                         BoltDevice  *dev)
+{
+  BoltDevice *parent;
 
-  return manager_find_device_by_syspath (mgr, path);
+  parent = g_hash_table_lookup (mgr->topo_parent, dev);
+
+  if (parent == NULL)
+    return NULL;
+
+  return g_object_ref (parent);
 }
 
 static GPtrArray *
 bolt_manager_get_children (BoltManager *mgr,
                            BoltDevice  *target)
 {
+  GPtrArray *children;
   GPtrArray *res;
 
   res = g_ptr_array_new_with_free_func (g_object_unref);
+  children = g_hash_table_lookup (mgr->topo_children, target);
 
-  for (guint i = 0; i < mgr->devices->len; i++)
-    {
-      g_autoptr(BoltDevice) parent = NULL;
-      BoltDevice *dev = g_ptr_array_index (mgr->devices, i);
-
-      parent = bolt_manager_get_parent (mgr, dev);
-      if (parent != target)
-        continue;
+  if (children == NULL)
+    return res;
 
+  for (guint i = 0; i < children->len; i++)
+    {
+      BoltDevice *dev = g_ptr_array_index (children, i);
       g_ptr_array_add (res, g_object_ref (dev));
     }
 
@@ -1076,7 +2440,8 @@ bolt_manager_label_device (BoltManager *mgr,
   g_autofree char *label = NULL;
   const char *name;
   const char *vendor;
-  guint count = 0;
+  const char *given = NULL;
+  guint count;
   static struct
   {
     const char *from;
@@ -1089,16 +2454,22 @@ bolt_manager_label_device (BoltManager *mgr,
   name = bolt_device_get_name (target);
   vendor = bolt_device_get_vendor (target);
 
-  /* we count how many duplicate devices we have */
-  for (guint i = 0; i < mgr->devices->len; i++)
-    {
-      BoltDevice *dev = g_ptr_array_index (mgr->devices, i);
-      const char *dev_name = bolt_device_get_name (dev);
-      const char *dev_vendor = bolt_device_get_vendor (dev);
+  /* how many duplicate devices we have */
+  count = manager_label_index_count (mgr, target);
+
+  /* a matching rule might provide a label */
+  manager_rules_match (mgr, target, &given);
 
-      if (bolt_streq (dev_name, name) &&
-          bolt_streq (dev_vendor, vendor))
-        count++;
+  if (given != NULL && count > 1)
+    label = g_strdup_printf ("%s #%u", given, count);
+  else if (given != NULL)
+    label = g_strdup (given);
+
+  if (label != NULL)
+    {
+      bolt_info (LOG_DEV (target), "labeling device: %s (rule)", label);
+      g_object_set (G_OBJECT (target), "label", label, NULL);
+      return;
     }
 
   /* cleanup name: nicer display names for vendors  */
@@ -1151,11 +2522,13 @@ static void
 maybe_authorize_device (BoltManager *mgr,
                         BoltDevice  *dev)
 {
+  g_autoptr(BoltDevice) parent = NULL;
   g_autoptr(BoltAuth) auth = NULL;
   BoltStatus status = bolt_device_get_status (dev);
   BoltPolicy policy = bolt_device_get_policy (dev);
   const char *uid = bolt_device_get_uid (dev);
   BoltKey *key = NULL;
+  BoltRuleAction action;
   BoltSecurity level;
   gboolean stored;
 
@@ -1169,15 +2542,24 @@ maybe_authorize_device (BoltManager *mgr,
     }
 
   if (bolt_status_is_authorized (status) ||
-      policy != BOLT_POLICY_AUTO)
+      status == BOLT_STATUS_AUTHORIZING)
+    return;
+
+  /* rules can only restrict stored policies, but
+   * grant 'auto' to devices without one */
+  action = manager_rules_match (mgr, dev, NULL);
+  if (action == BOLT_RULE_DENY || action == BOLT_RULE_MANUAL)
+    policy = BOLT_POLICY_MANUAL;
+  else if (action == BOLT_RULE_AUTO && policy == BOLT_POLICY_DEFAULT)
+    policy = BOLT_POLICY_AUTO;
+
+  if (policy != BOLT_POLICY_AUTO)
     return;
 
   stored = bolt_device_get_stored (dev);
-  /* sanity check, because we already checked the policy */
-  g_return_if_fail (stored);
 
   level = bolt_device_get_security (dev);
-  if (level == BOLT_SECURITY_SECURE &&
+  if (level == BOLT_SECURITY_SECURE && stored &&
       bolt_device_get_keystate (dev) != BOLT_KEY_MISSING)
     {
       g_autoptr(GError) err = NULL;
@@ -1193,7 +2575,17 @@ maybe_authorize_device (BoltManager *mgr,
     }
 
   auth = bolt_auth_new (mgr, level, key);
-  bolt_device_authorize_idle (dev, auth, authorize_device_finish, mgr);
+
+  /* if the parent is currently being authorized, we get
+   * chained to it and will be authorized directly after */
+  parent = bolt_manager_get_parent (mgr, dev);
+
+  if (parent != NULL &&
+      bolt_device_get_status (parent) == BOLT_STATUS_AUTHORIZING)
+    bolt_device_authorize_after (dev, parent, auth,
+                                 authorize_device_finish, mgr);
+  else
+    bolt_device_authorize_idle (dev, auth, authorize_device_finish, mgr);
 }
 
 static void
@@ -1202,6 +2594,8 @@ manager_maybe_auto_import_device (BoltManager *mgr,
 {
   g_autoptr(GError) err = NULL;
   g_autoptr(BoltKey) key = NULL;
+  BoltRuleAction action;
+  BoltPolicy policy;
   gboolean boot;
   gboolean ok;
 
@@ -1211,6 +2605,16 @@ manager_maybe_auto_import_device (BoltManager *mgr,
   if (bolt_device_get_device_type (dev) == BOLT_DEVICE_HOST)
     return;
 
+  action = manager_rules_match (mgr, dev, NULL);
+  if (action == BOLT_RULE_DENY)
+    {
+      bolt_msg (LOG_DEV (dev), LOG_TOPIC ("auto-import"),
+                "denied by rule, not auto-importing");
+      return;
+    }
+
+  policy = action == BOLT_RULE_MANUAL ? BOLT_POLICY_MANUAL : BOLT_POLICY_AUTO;
+
   boot = bolt_device_check_authflag (dev, BOLT_AUTH_BOOT);
 
   if (!boot)
@@ -1239,27 +2643,287 @@ manager_maybe_auto_import_device (BoltManager *mgr,
             "new authorized device (boot: %s, key: %s), importing",
             bolt_yesno (boot), bolt_yesno (key != NULL));
 
-  ok = bolt_store_put_device (mgr->store, dev, BOLT_POLICY_AUTO, key, &err);
+  ok = bolt_store_put_device (mgr->store, dev, policy, key, &err);
 
   if (!ok)
     bolt_warn_err (err, LOG_DEV (dev), LOG_TOPIC ("auto-import"),
                    "failed to store device");
 }
 
+/* deferred work */
+typedef struct DeferredJob
+{
+  DeferredFunc func;
+  BoltDevice  *dev;
+} DeferredJob;
+
+static void
+deferred_job_free (gpointer data)
+{
+  DeferredJob *job = data;
+
+  g_object_unref (job->dev);
+  g_slice_free (DeferredJob, job);
+}
+
+static gboolean
+manager_deferred_run_one (BoltManager *mgr)
+{
+  DeferredJob *job;
+  const char *uid;
+
+  job = g_queue_pop_head (&mgr->deferred);
+
+  if (job == NULL)
+    return FALSE;
+
+  uid = bolt_device_get_uid (job->dev);
+
+  /* the device might have been removed meanwhile */
+  if (g_hash_table_lookup (mgr->uid_index, uid) == job->dev)
+    job->func (mgr, job->dev);
+
+  deferred_job_free (job);
+  return TRUE;
+}
+
+static gboolean
+deferred_run_idle (gpointer user_data)
+{
+  BoltManager *mgr = BOLT_MANAGER (user_data);
+
+  manager_deferred_run_one (mgr);
+
+  if (!g_queue_is_empty (&mgr->deferred))
+    return G_SOURCE_CONTINUE;
+
+  mgr->deferred_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+/* D-Bus methods that look at devices run all pending
+ * jobs first, so clients always get a consistent view */
+static void
+manager_deferred_flush (BoltManager *mgr)
+{
+  while (manager_deferred_run_one (mgr))
+    ;
+
+  if (mgr->deferred_source != 0)
+    {
+      g_source_remove (mgr->deferred_source);
+      mgr->deferred_source = 0;
+    }
+}
+
+/* Work that is not needed to make authorization decisions
+ * (labeling, store writes, D-Bus export and notifications)
+ * is queued and run from a low priority idle source, one
+ * job per main loop iteration, so uevents and pending
+ * authorizations always go first. Jobs are run in the
+ * order they were queued, thus also in order per device.
+ */
+static void
+manager_defer (BoltManager *mgr,
+               BoltDevice  *dev,
+               DeferredFunc func)
+{
+  DeferredJob *job;
+
+  job = g_slice_new (DeferredJob);
+  job->func = func;
+  job->dev = g_object_ref (dev);
+
+  g_queue_push_tail (&mgr->deferred, job);
+
+  if (mgr->deferred_source != 0)
+    return;
+
+  mgr->deferred_source = g_idle_add_full (G_PRIORITY_LOW,
+                                          deferred_run_idle,
+                                          mgr, NULL);
+}
+
+/* hotplug storms: if the rate of uevents exceeds a threshold,
+ * we switch to batch mode, where events are queued and then
+ * handled together at a fixed interval. During a batch, all
+ * property notifications of the devices are held back, so
+ * that each device emits at most one PropertiesChanged per
+ * batch; change events are coalesced over the whole batch and
+ * logging is summarized per batch. Once the rate drops below
+ * the threshold, we are back to handling events right away.
+ */
+typedef struct QueuedEvent
+{
+  char               *action;
+  struct udev_device *device;
+} QueuedEvent;
+
+static void
+queued_event_free (gpointer data)
+{
+  QueuedEvent *ev = data;
+
+  g_free (ev->action);
+  udev_device_unref (ev->device);
+  g_slice_free (QueuedEvent, ev);
+}
+
+/* hold back property notifications of all devices, so
+ * that each one emits at most one PropertiesChanged for
+ * a whole batch of events; see manager_thaw_notify */
+static GPtrArray *
+manager_freeze_notify (BoltManager *mgr)
+{
+  GPtrArray *frozen;
+
+  frozen = g_ptr_array_new_full (mgr->devices->len, g_object_unref);
+
+  for (guint i = 0; i < mgr->devices->len; i++)
+    {
+      GObject *dev = g_ptr_array_index (mgr->devices, i);
+
+      g_object_freeze_notify (dev);
+      g_ptr_array_add (frozen, g_object_ref (dev));
+    }
+
+  return frozen;
+}
+
+static void
+manager_thaw_notify (GPtrArray *frozen)
+{
+  for (guint i = 0; i < frozen->len; i++)
+    g_object_thaw_notify (g_ptr_array_index (frozen, i));
+
+  g_ptr_array_unref (frozen);
+}
+
+static gboolean
+storm_batch_timeout (gpointer user_data)
+{
+  BoltManager *mgr = BOLT_MANAGER (user_data);
+  GPtrArray *frozen;
+  QueuedEvent *ev;
+  gint64 start, dt;
+  guint n;
+
+  start = g_get_monotonic_time ();
+  n = g_queue_get_length (&mgr->storm_queue);
+
+  frozen = manager_freeze_notify (mgr);
+
+  while ((ev = g_queue_pop_head (&mgr->storm_queue)) != NULL)
+    {
+      manager_handle_uevent (mgr, ev->action, ev->device);
+      queued_event_free (ev);
+    }
+
+  manager_coalesce_flush (mgr);
+
+  manager_thaw_notify (frozen);
+
+  dt = g_get_monotonic_time () - start;
+  mgr->storm_busy += dt;
+  mgr->storm_events += n;
+
+  bolt_info (LOG_TOPIC ("storm"), "batch: %u events in %" G_GINT64_FORMAT " us",
+             n, dt);
+
+  if (n >= STORM_BATCH_MIN)
+    return G_SOURCE_CONTINUE;
+
+  dt = bolt_clock_get_time (mgr->clock) - mgr->storm_start;
+  bolt_msg (LOG_TOPIC ("storm"), "leaving batch mode: %" G_GUINT64_FORMAT
+            " events in %" G_GINT64_FORMAT " ms, processing took %"
+            G_GINT64_FORMAT " ms [storms: %u]", mgr->storm_events,
+            dt / 1000, mgr->storm_busy / 1000, mgr->storm_count);
+
+  mgr->storm_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+manager_storm_check (BoltManager *mgr)
+{
+  gint64 now = bolt_clock_get_time (mgr->clock);
+
+  if (now - mgr->storm_wstart > STORM_WINDOW_MS * MSEC_PER_USEC)
+    {
+      mgr->storm_wstart = now;
+      mgr->storm_wcount = 0;
+    }
+
+  mgr->storm_wcount++;
+
+  if (mgr->storm_source != 0)
+    return TRUE;
+
+  if (mgr->storm_wcount < STORM_THRESHOLD)
+    return FALSE;
+
+  mgr->storm_count++;
+  mgr->storm_start = now;
+  mgr->storm_events = 0;
+  mgr->storm_busy = 0;
+
+  bolt_msg (LOG_TOPIC ("storm"), "%u events within %d ms, entering batch mode",
+            mgr->storm_wcount, STORM_WINDOW_MS);
+
+  mgr->storm_source = bolt_clock_timeout_add (mgr->clock,
+                                              STORM_BATCH_MS,
+                                              storm_batch_timeout,
+                                              mgr);
+  return TRUE;
+}
+
 /* udev callbacks */
 static void
-handle_uevent_udev (BoltUdev           *udev,
-                    const char         *action,
-                    struct udev_device *device,
-                    gpointer            user_data)
+handle_uevent_batch_udev (BoltUdev  *udev,
+                          GPtrArray *batch,
+                          gpointer   user_data)
+{
+  BoltManager *mgr = BOLT_MANAGER (user_data);
+  GPtrArray *frozen = NULL;
+
+  g_atomic_int_add (&mgr->idle_activity->count, (gint) batch->len);
+
+  /* events that arrived together are handled together */
+  if (batch->len > 1)
+    frozen = manager_freeze_notify (mgr);
+
+  for (guint i = 0; i < batch->len; i++)
+    {
+      struct udev_device *device = g_ptr_array_index (batch, i);
+      const char *action = udev_device_get_action (device);
+      QueuedEvent *ev;
+
+      if (!manager_storm_check (mgr))
+        {
+          manager_handle_uevent (mgr, action, device);
+          continue;
+        }
+
+      ev = g_slice_new (QueuedEvent);
+      ev->action = g_strdup (action);
+      ev->device = udev_device_ref (device);
+
+      g_queue_push_tail (&mgr->storm_queue, ev);
+    }
+
+  if (frozen != NULL)
+    manager_thaw_notify (frozen);
+}
+
+static void
+manager_handle_uevent (BoltManager        *mgr,
+                       const char         *action,
+                       struct udev_device *device)
 {
-  BoltManager *mgr;
   const char *subsystem;
   const char *devtype;
   const char *syspath;
 
-  mgr = BOLT_MANAGER (user_data);
-
   devtype = udev_device_get_devtype (device);
   subsystem = udev_device_get_subsystem (device);
   syspath = udev_device_get_syspath (device);
@@ -1278,12 +2942,133 @@ handle_uevent_udev (BoltUdev           *udev,
               subsystem, devtype ? "/" : "", devtype ? : "",
               syspath);
 
+  /* bursts of 'change' events for the same device are
+   * merged; everything else is strictly ordered after
+   * all the pending 'change' events */
+  if (bolt_streq (devtype, "thunderbolt_device") &&
+      g_str_equal (action, "change"))
+    {
+      manager_coalesce_change (mgr, device);
+      return;
+    }
+
+  manager_coalesce_flush (mgr);
+
   if (bolt_streq (devtype, "thunderbolt_device"))
     handle_udev_device_event (mgr, device, action);
   else if (bolt_streq (devtype, "thunderbolt_domain"))
     handle_udev_domain_event (mgr, device, action);
 }
 
+static gboolean
+coalesce_flush_timeout (gpointer user_data)
+{
+  BoltManager *mgr = BOLT_MANAGER (user_data);
+
+  mgr->coalesce_source = 0;
+  manager_coalesce_flush (mgr);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+manager_coalesce_change (BoltManager        *mgr,
+                         struct udev_device *device)
+{
+  const char *syspath;
+  gpointer pos;
+
+  syspath = udev_device_get_syspath (device);
+  pos = g_hash_table_lookup (mgr->coalesce_index, syspath);
+
+  if (pos != NULL)
+    {
+      guint idx = GPOINTER_TO_UINT (pos) - 1;
+      struct udev_device *old;
+
+      /* replace the pending event with the newer one, but
+       * keep its position so the order among devices is
+       * preserved */
+      old = g_ptr_array_index (mgr->coalesce_queue, idx);
+      g_ptr_array_index (mgr->coalesce_queue, idx) = udev_device_ref (device);
+      udev_device_unref (old);
+
+      mgr->coalesce_batch++;
+      bolt_debug (LOG_TOPIC ("udev"), "change coalesced: %s", syspath);
+      return;
+    }
+
+  g_ptr_array_add (mgr->coalesce_queue, udev_device_ref (device));
+  pos = GUINT_TO_POINTER (mgr->coalesce_queue->len);
+  g_hash_table_insert (mgr->coalesce_index, g_strdup (syspath), pos);
+
+  if (mgr->coalesce_source)
+    return;
+
+  /* the idle source does not depend on the clock */
+  mgr->coalesce_idle = mgr->coalesce_window == 0;
+
+  if (mgr->coalesce_window > 0)
+    mgr->coalesce_source = bolt_clock_timeout_add (mgr->clock,
+                                                   mgr->coalesce_window,
+                                                   coalesce_flush_timeout,
+                                                   mgr);
+  else
+    mgr->coalesce_source = g_idle_add_full (G_PRIORITY_LOW,
+                                            coalesce_flush_timeout,
+                                            mgr, NULL);
+}
+
+static void
+manager_coalesce_cancel (BoltManager *mgr)
+{
+  if (mgr->coalesce_source == 0)
+    return;
+
+  if (mgr->coalesce_idle)
+    g_source_remove (mgr->coalesce_source);
+  else
+    bolt_clock_source_remove (mgr->clock, mgr->coalesce_source);
+
+  mgr->coalesce_source = 0;
+}
+
+static void
+manager_coalesce_flush (BoltManager *mgr)
+{
+  g_autoptr(GPtrArray) queue = NULL;
+
+  manager_coalesce_cancel (mgr);
+
+  if (mgr->coalesce_queue->len == 0)
+    return;
+
+  /* swap out the queue, handling the events might
+   * lead to new events being queued */
+  queue = mgr->coalesce_queue;
+  mgr->coalesce_queue = g_ptr_array_new_with_free_func ((GDestroyNotify) udev_device_unref);
+  g_hash_table_remove_all (mgr->coalesce_index);
+
+  if (mgr->coalesce_batch > 0)
+    {
+      mgr->coalesce_merged += mgr->coalesce_batch;
+      bolt_info (LOG_TOPIC ("udev"), "coalesced %u change events into %u "
+                 "[total: %" G_GUINT64_FORMAT "]",
+                 mgr->coalesce_batch + queue->len, queue->len,
+                 mgr->coalesce_merged);
+      mgr->coalesce_batch = 0;
+
+      g_object_notify_by_pspec (G_OBJECT (mgr), props[PROP_COALESCED]);
+    }
+
+  for (guint i = 0; i < queue->len; i++)
+    {
+      struct udev_device *device = g_ptr_array_index (queue, i);
+
+      handle_udev_device_event (mgr, device, "change");
+    }
+}
+
 static void
 handle_udev_domain_event (BoltManager        *mgr,
                           struct udev_device *device,
@@ -1298,6 +3083,9 @@ handle_udev_domain_event (BoltManager        *mgr,
     {
       manager_probing_domain_added (mgr, device);
 
+      if (mgr->power_guard != NULL)
+        manager_power_wait_done (mgr, "domain appeared");
+
       /* the creation of the actual domain object and
        * its registration is handled on-demand: only
        * when the host device appears, the uevent
@@ -1437,13 +3225,7 @@ handle_udev_device_added (BoltManager        *mgr,
                           struct udev_device *udev)
 {
   g_autoptr(GError) err = NULL;
-  GDBusConnection *bus;
   BoltDevice *dev;
-  BoltStatus status;
-  const char *opath;
-  const char *syspath;
-
-  syspath = udev_device_get_syspath (udev);
 
   dev = bolt_device_new_for_udev (udev, domain, &err);
   if (dev == NULL)
@@ -1452,27 +3234,96 @@ handle_udev_device_added (BoltManager        *mgr,
       return;
     }
 
+  handle_device_added (mgr, dev);
+}
+
+static void
+handle_device_added (BoltManager *mgr,
+                     BoltDevice  *dev)
+{
+  BoltStatus status;
+  const char *syspath;
+
+  syspath = bolt_device_get_syspath (dev);
+
+  /* critical: the device must be known, and linked into
+   * the topology, before its children can be handled */
   manager_register_device (mgr, dev);
+  manager_topology_link (mgr, dev);
+  manager_rules_apply (mgr, dev);
 
   status = bolt_device_get_status (dev);
   bolt_msg (LOG_DEV (dev), "device added, status: %s, at %s",
             bolt_status_to_string (status), syspath);
 
-  bolt_manager_label_device (mgr, dev);
+  /* authorization is latency critical and thus never deferred */
+  manager_maybe_authorize_new_device (mgr, dev);
+
+  manager_history_connect (mgr, dev);
+
+  /* bookkeeping: done once there is nothing more
+   * important to do, in exactly this order */
+  manager_defer (mgr, dev, bolt_manager_label_device);
+  manager_defer (mgr, dev, manager_maybe_auto_import_device);
+  manager_defer (mgr, dev, deferred_device_export);
+}
+
+static void
+manager_maybe_authorize_new_device (BoltManager *mgr,
+                                    BoltDevice  *dev)
+{
+  BoltDevice *parent;
+  BoltStatus status;
+
+  /* only rules can authorize devices that are not stored */
+  if (mgr->rules == NULL)
+    return;
+
+  status = bolt_device_get_status (dev);
+  if (status != BOLT_STATUS_CONNECTED)
+    return;
+
+  /* otherwise we will get another chance once
+   * the parent is authorized, see the status change handler */
+  parent = g_hash_table_lookup (mgr->topo_parent, dev);
+  if (parent != NULL)
+    {
+      status = bolt_device_get_status (parent);
+      if (!bolt_status_is_authorized (status) &&
+          status != BOLT_STATUS_AUTHORIZING)
+        return;
+    }
 
-  manager_maybe_auto_import_device (mgr, dev);
+  maybe_authorize_device (mgr, dev);
+}
+
+static void
+deferred_device_export (BoltManager *mgr,
+                        BoltDevice  *dev)
+{
+  g_autoptr(GError) err = NULL;
+  GDBusConnection *bus;
+  const char *opath;
 
   /* if we have a valid dbus connection */
   bus = bolt_exported_get_connection (BOLT_EXPORTED (mgr));
   if (bus == NULL)
     return;
 
+  /* devices present at startup are exported together
+   * with the manager, see bolt_manager_export () */
+  if (bolt_exported_is_exported (BOLT_EXPORTED (dev)))
+    return;
+
   opath = bolt_device_export (dev, bus, &err);
   if (opath == NULL)
-    bolt_warn_err (err, LOG_DEV (dev), LOG_TOPIC ("dbus"), "error exporting");
-  else
-    bolt_info (LOG_DEV (dev), LOG_TOPIC ("dbus"),
-               "exported device at %.43s...", opath);
+    {
+      bolt_warn_err (err, LOG_DEV (dev), LOG_TOPIC ("dbus"), "error exporting");
+      return;
+    }
+
+  bolt_info (LOG_DEV (dev), LOG_TOPIC ("dbus"),
+             "exported device at %.43s...", opath);
 
   bolt_exported_emit_signal (BOLT_EXPORTED (mgr),
                              "DeviceAdded",
@@ -1512,6 +3363,10 @@ handle_udev_device_removed (BoltManager *mgr,
   syspath = bolt_device_get_syspath (dev);
   bolt_msg (LOG_DEV (dev), "removed (%s)", syspath);
 
+  manager_history_put (mgr, bolt_device_get_uid (dev),
+                       BOLT_HISTORY_DISCONNECT,
+                       BOLT_HISTORY_RESULT_NONE, 0);
+
   manager_deregister_device (mgr, dev);
 
   opath = bolt_device_get_object_path (dev);
@@ -1540,10 +3395,14 @@ handle_udev_device_attached (BoltManager        *mgr,
 
   syspath = udev_device_get_syspath (udev);
   status = bolt_device_connected (dev, domain, udev);
+  manager_topology_link (mgr, dev);
+  manager_rules_apply (mgr, dev);
 
   bolt_msg (LOG_DEV (dev), "connected: %s (%s)",
             bolt_status_to_string (status), syspath);
 
+  manager_history_connect (mgr, dev);
+
   if (status != BOLT_STATUS_CONNECTED)
     return;
 
@@ -1552,7 +3411,11 @@ handle_udev_device_attached (BoltManager        *mgr,
     {
       const char *pid = bolt_device_get_uid (parent);
       status = bolt_device_get_status (parent);
-      if (!bolt_status_is_authorized (status))
+
+      /* if the parent is authorizing, we stage our own
+       * authorization, so it can follow right away */
+      if (!bolt_status_is_authorized (status) &&
+          status != BOLT_STATUS_AUTHORIZING)
         {
           bolt_info (LOG_DEV (dev), "parent [%s] not authorized", pid);
           return;
@@ -1575,6 +3438,11 @@ handle_udev_device_detached (BoltManager *mgr,
   syspath = bolt_device_get_syspath (dev);
   bolt_msg (LOG_DEV (dev), "disconnected (%s)", syspath);
 
+  manager_history_put (mgr, bolt_device_get_uid (dev),
+                       BOLT_HISTORY_DISCONNECT,
+                       BOLT_HISTORY_RESULT_NONE, 0);
+
+  manager_topology_unlink (mgr, dev);
   bolt_device_disconnected (dev);
 }
 
@@ -1652,6 +3520,9 @@ handle_store_device_added (BoltStore   *store,
   BoltDomain *dom = mgr->domains;
   BootaclCtx ctx = {mgr, uid};
 
+  manager_history_put (mgr, uid, BOLT_HISTORY_ENROLL,
+                       BOLT_HISTORY_RESULT_NONE, 0);
+
   dev = manager_find_device_by_uid (mgr, uid, NULL);
 
   if (dev == NULL || dom == NULL)
@@ -1679,6 +3550,9 @@ handle_store_device_removed (BoltStore   *store,
   BoltStatus status;
   const char *opath;
 
+  manager_history_put (mgr, uid, BOLT_HISTORY_FORGET,
+                       BOLT_HISTORY_RESULT_NONE, 0);
+
   dev = manager_find_device_by_uid (mgr, uid, NULL);
 
   if (!dev)
@@ -1729,6 +3603,28 @@ handle_domain_security_changed (BoltManager *mgr,
     manager_maybe_set_security (mgr, security);
 }
 
+static void
+handle_domain_syspath_changed (BoltManager *mgr,
+                               GParamSpec  *unused,
+                               BoltDomain  *domain)
+{
+  const char *syspath = bolt_domain_get_syspath (domain);
+
+  manager_index_set (mgr->domain_index, mgr->domain_keys,
+                     domain, syspath);
+}
+
+static void
+handle_device_syspath_changed (BoltManager *mgr,
+                               GParamSpec  *unused,
+                               BoltDevice  *dev)
+{
+  const char *syspath = bolt_device_get_syspath (dev);
+
+  manager_index_set (mgr->sysfs_index, mgr->sysfs_keys,
+                     dev, syspath);
+}
+
 
 static void
 handle_device_status_changed (BoltDevice  *dev,
@@ -1747,11 +3643,17 @@ handle_device_status_changed (BoltDevice  *dev,
   if (now == old)
     return; /* sanity check */
 
+  /* only move devices that are still registered */
+  if (manager_status_index_remove (mgr, dev, old))
+    manager_status_index_add (mgr, dev, now);
+
   if (now == BOLT_STATUS_AUTHORIZING)
     mgr->authorizing += 1;
   else if (old == BOLT_STATUS_AUTHORIZING)
     mgr->authorizing -= 1;
 
+  manager_history_status (mgr, dev, old, now);
+
   manager_probing_activity (mgr, !mgr->authorizing);
 
   if (now != BOLT_STATUS_AUTHORIZED)
@@ -1793,25 +3695,44 @@ probing_timeout (gpointer user_data)
 {
   BoltManager *mgr;
   gint64 now, dt, timeout;
+  guint remaining;
 
   mgr = BOLT_MANAGER (user_data);
 
+  /* the settle time can change while we are waiting,
+   * therefore the timeout is re-armed every time */
   if (mgr->authorizing > 0)
-    return G_SOURCE_CONTINUE;
+    {
+      mgr->probing_timeout = bolt_clock_timeout_add (mgr->clock,
+                                                     mgr->probing_tsettle,
+                                                     probing_timeout,
+                                                     mgr);
+      return G_SOURCE_REMOVE;
+    }
 
-  now = g_get_monotonic_time ();
+  now = bolt_clock_get_time (mgr->clock);
   dt = now - mgr->probing_tstamp;
 
   /* dt is in microseconds, probing timeout in
    * milli seconds  */
   timeout = mgr->probing_tsettle * MSEC_PER_USEC;
   if (dt < timeout)
-    return G_SOURCE_CONTINUE;
+    {
+      remaining = (guint) ((timeout - dt + MSEC_PER_USEC - 1) / MSEC_PER_USEC);
+      mgr->probing_timeout = bolt_clock_timeout_add (mgr->clock, remaining,
+                                                     probing_timeout, mgr);
+      return G_SOURCE_REMOVE;
+    }
 
   /* we are done, remove us */
   mgr->probing_timeout = 0;
   g_object_notify_by_pspec (G_OBJECT (mgr), props[PROP_PROBING]);
-  bolt_info (LOG_TOPIC ("probing"), "timeout, done: [%ld] (%ld)", dt, timeout);
+  bolt_info (LOG_TOPIC ("probing"), "timeout, done: [%ld] (%ld), %"
+             G_GUINT64_FORMAT " events", dt, timeout, mgr->probing_events);
+
+  mgr->probing_tsettle = PROBING_SETTLE_TIME_MS;
+  mgr->probing_events = 0;
+
   return G_SOURCE_REMOVE;
 }
 
@@ -1821,16 +3742,96 @@ manager_probing_activity (BoltManager *mgr,
 {
   guint dt;
 
-  mgr->probing_tstamp = g_get_monotonic_time ();
+  mgr->probing_tstamp = bolt_clock_get_time (mgr->clock);
   if (mgr->probing_timeout || weak)
     return;
 
   dt = mgr->probing_tsettle / 2;
   bolt_info (LOG_TOPIC ("probing"), "started [%u]", dt);
-  mgr->probing_timeout = g_timeout_add (dt, probing_timeout, mgr);
+  mgr->probing_timeout = bolt_clock_timeout_add (mgr->clock, dt,
+                                                 probing_timeout, mgr);
   g_object_notify_by_pspec (G_OBJECT (mgr), props[PROP_PROBING]);
 }
 
+/* gaps between events behind a root are recorded in a
+ * histogram with power of two buckets (in ms); gaps as
+ * long as the fallback settle time start a new burst
+ * and are thus not part of the distribution */
+static void
+probing_root_record (ProbingNode *root,
+                     gint64       now)
+{
+  gint64 gap;
+  guint ms, bucket = 0;
+
+  root->events++;
+
+  if (root->last > 0)
+    {
+      gap = (now - root->last) / MSEC_PER_USEC;
+
+      if (gap < PROBING_SETTLE_TIME_MS)
+        {
+          for (ms = (guint) gap; ms > 1 && bucket < PROBING_GAP_BUCKETS - 1; ms >>= 1)
+            bucket++;
+
+          root->gaps[bucket]++;
+          root->ngaps++;
+        }
+    }
+
+  root->last = now;
+}
+
+/* the settle time for a root is the upper bound of the
+ * bucket containing the configured percentile of the
+ * observed gaps, times a safety margin */
+static guint
+probing_root_settle_time (ProbingNode *root)
+{
+  guint threshold;
+  guint count = 0;
+  guint settle;
+  guint i;
+
+  if (root->ngaps < PROBING_GAP_SAMPLES)
+    return PROBING_SETTLE_TIME_MS;
+
+  threshold = (root->ngaps * PROBING_GAP_PERCENTILE + 99) / 100;
+
+  for (i = 0; i < PROBING_GAP_BUCKETS - 1; i++)
+    {
+      count += root->gaps[i];
+      if (count >= threshold)
+        break;
+    }
+
+  settle = (2U << i) * PROBING_SETTLE_MARGIN;
+
+  return CLAMP (settle, PROBING_SETTLE_MIN_MS, PROBING_SETTLE_TIME_MS);
+}
+
+static void
+manager_probing_root_activity (BoltManager *mgr,
+                               ProbingNode *root)
+{
+  gint64 now = bolt_clock_get_time (mgr->clock);
+  guint settle;
+
+  probing_root_record (root, now);
+  settle = probing_root_settle_time (root);
+
+  /* a new probing period uses the estimate for the root
+   * that triggered it, later activity can only extend it */
+  if (mgr->probing_timeout == 0)
+    mgr->probing_tsettle = settle;
+  else
+    mgr->probing_tsettle = MAX (mgr->probing_tsettle, settle);
+
+  mgr->probing_events++;
+  manager_probing_activity (mgr, FALSE);
+}
+
 static gboolean
 device_is_thunderbolt_root (struct udev_device *dev)
 {
@@ -1844,12 +3845,114 @@ device_is_thunderbolt_root (struct udev_device *dev)
          bolt_streq (driver, "thunderbolt");
 }
 
+static ProbingNode *
+probing_node_new (void)
+{
+  ProbingNode *node = g_slice_new0 (ProbingNode);
+
+  node->children = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, probing_node_free);
+  return node;
+}
+
+static void
+probing_node_free (gpointer data)
+{
+  ProbingNode *node = data;
+
+  g_hash_table_unref (node->children);
+  g_slice_free (ProbingNode, node);
+}
+
+static gboolean
+probing_trie_insert (ProbingNode *node,
+                     const char  *path)
+{
+  g_auto(GStrv) comps = g_strsplit (path, "/", -1);
+  gboolean added;
+
+  for (guint i = 0; comps[i] != NULL; i++)
+    {
+      ProbingNode *next;
+
+      if (*comps[i] == '\0')
+        continue;
+
+      next = g_hash_table_lookup (node->children, comps[i]);
+
+      if (next == NULL)
+        {
+          next = probing_node_new ();
+          g_hash_table_insert (node->children, g_strdup (comps[i]), next);
+        }
+
+      node = next;
+    }
+
+  added = !node->is_root;
+  node->is_root = TRUE;
+
+  return added;
+}
+
 static gboolean
+probing_trie_remove (ProbingNode *node,
+                     const char  *path)
+{
+  g_auto(GStrv) comps = g_strsplit (path, "/", -1);
+  gboolean removed;
+
+  for (guint i = 0; node != NULL && comps[i] != NULL; i++)
+    if (*comps[i] != '\0')
+      node = g_hash_table_lookup (node->children, comps[i]);
+
+  if (node == NULL)
+    return FALSE;
+
+  /* the now superfluous nodes are kept, roots come and
+   * go at the same few places in the tree */
+  removed = node->is_root;
+  node->is_root = FALSE;
+
+  return removed;
+}
+
+static ProbingNode *
+probing_trie_match (ProbingNode *node,
+                    const char  *path)
+{
+  g_autofree char *buf = g_strdup (path);
+  char *comp = buf;
+
+  /* walk down the components, stop at the first
+   * root on the way or when we fall off the trie */
+  while (node != NULL && !node->is_root)
+    {
+      char *end;
+
+      while (*comp == '/')
+        comp++;
+
+      if (*comp == '\0')
+        return NULL;
+
+      end = strchr (comp, '/');
+      if (end != NULL)
+        *end++ = '\0';
+
+      node = g_hash_table_lookup (node->children, comp);
+      comp = end ? : comp + strlen (comp);
+    }
+
+  return node;
+}
+
+static ProbingNode *
 probing_add_root (BoltManager        *mgr,
                   struct udev_device *dev)
 {
   const char *syspath;
-  GPtrArray *roots;
+  gboolean added;
 
   g_return_val_if_fail (device_is_thunderbolt_root (dev), FALSE);
 
@@ -1858,40 +3961,35 @@ probing_add_root (BoltManager        *mgr,
     dev = udev_device_get_parent (dev);
 
   if (dev == NULL)
-    return FALSE;
+    return NULL;
 
-  roots = mgr->probing_roots;
   syspath = udev_device_get_syspath (dev);
-  g_ptr_array_add (roots, g_strdup (syspath));
-  bolt_info (LOG_TOPIC ("probing"), "adding %s to roots", syspath);
+  added = probing_trie_insert (mgr->probing_roots, syspath);
 
-  return TRUE;
+  if (added)
+    bolt_info (LOG_TOPIC ("probing"), "adding %s to roots", syspath);
+
+  return probing_trie_match (mgr->probing_roots, syspath);
 }
 
 static void
 manager_probing_device_added (BoltManager        *mgr,
                               struct udev_device *dev)
 {
+  ProbingNode *root;
   const char *syspath;
-  GPtrArray *roots;
-  gboolean added;
 
   syspath = udev_device_get_syspath (dev);
 
   if (syspath == NULL)
     return;
 
-  roots = mgr->probing_roots;
-  for (guint i = 0; i < roots->len; i++)
+  root = probing_trie_match (mgr->probing_roots, syspath);
+  if (root != NULL)
     {
-      const char *r = g_ptr_array_index (roots, i);
-      if (g_str_has_prefix (syspath, r))
-        {
-          bolt_debug (LOG_TOPIC ("probing"), "match %s", syspath);
-          /* do something */
-          manager_probing_activity (mgr, FALSE);
-          return;
-        }
+      bolt_debug (LOG_TOPIC ("probing"), "match %s", syspath);
+      manager_probing_root_activity (mgr, root);
+      return;
     }
 
   /* if we ended up here we didn't find a root,
@@ -1900,40 +3998,36 @@ manager_probing_device_added (BoltManager        *mgr,
   if (!device_is_thunderbolt_root (dev))
     return;
 
-  added = probing_add_root (mgr, dev);
-  if (added)
-    manager_probing_activity (mgr, FALSE);
+  root = probing_add_root (mgr, dev);
+  if (root != NULL)
+    manager_probing_root_activity (mgr, root);
 }
 
 static void
 manager_probing_device_removed (BoltManager        *mgr,
                                 struct udev_device *dev)
 {
+  ProbingNode *root;
   const char *syspath;
-  GPtrArray *roots;
   gboolean found;
-  guint index;
 
   syspath = udev_device_get_syspath (dev);
 
   if (syspath == NULL)
     return;
 
-  roots = mgr->probing_roots;
-  found = FALSE;
-  for (index = 0; index < roots->len; index++)
-    {
-      const char *r = g_ptr_array_index (roots, index);
-      found = g_str_equal (syspath, r);
-      if (found)
-        break;
-    }
+  root = probing_trie_match (mgr->probing_roots, syspath);
+  found = probing_trie_remove (mgr->probing_roots, syspath);
 
   if (!found)
     return;
 
-  bolt_info (LOG_TOPIC ("probing"), "removing %s from roots", syspath);
-  g_ptr_array_remove_index_fast (mgr->probing_roots, index);
+  /* the gap to the first event after a replug is meaningless */
+  root->last = 0;
+
+  bolt_info (LOG_TOPIC ("probing"), "removing %s from roots "
+             "[events: %" G_GUINT64_FORMAT ", settle: %u ms]",
+             syspath, root->events, probing_root_settle_time (root));
 }
 
 static void
@@ -1987,12 +4081,17 @@ manager_maybe_power_controller (BoltManager *mgr)
     }
 
   /* we wait for a total of 5.0 seconds, should hopefully
-   * be enough for at least the domain to show up. */
-  for (int i = 0; i < 25 && n < 1; i++)
-    {
-      g_usleep (200000); /* 200 000 us = 0.2s */
-      n = bolt_udev_count_domains (mgr->udev, NULL);
-    }
+   * be enough for at least the domain to show up; the
+   * domain 'add' uevent will end the wait early */
+  mgr->power_wait = bolt_clock_timeout_add (mgr->clock,
+                                            POWER_WAIT_TIME_MS,
+                                            power_wait_timeout,
+                                            mgr);
+
+  bolt_info (LOG_TOPIC ("udev"), "no domains, waiting for %d ms",
+             POWER_WAIT_TIME_MS);
+
+  return guard;
 
 out:
   bolt_info (LOG_TOPIC ("udev"), "found %d domain%s",
@@ -2000,6 +4099,315 @@ out:
   return guard;
 }
 
+static gboolean
+power_wait_timeout (gpointer user_data)
+{
+  BoltManager *mgr = BOLT_MANAGER (user_data);
+
+  mgr->power_wait = 0;
+  manager_power_wait_done (mgr, "timeout");
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+manager_power_wait_done (BoltManager *mgr,
+                         const char  *reason)
+{
+  g_autoptr(BoltPowerGuard) guard = NULL;
+
+  if (mgr->power_wait)
+    {
+      bolt_clock_source_remove (mgr->clock, mgr->power_wait);
+      mgr->power_wait = 0;
+    }
+
+  guard = g_steal_pointer (&mgr->power_guard);
+
+  if (guard == NULL)
+    return;
+
+  bolt_info (LOG_TOPIC ("power"), "done waiting for domains (%s), "
+             "releasing guard '%s'", reason,
+             bolt_power_guard_get_id (guard));
+}
+
+
+/* device event history */
+static void
+manager_history_open (BoltManager *mgr)
+{
+  g_autoptr(GError) err = NULL;
+
+  mgr->history = bolt_store_open_history (mgr->store, HISTORY_FILENAME, &err);
+
+  if (mgr->history == NULL)
+    bolt_warn_err (err, LOG_TOPIC ("history"), "failed to open history");
+}
+
+static void
+manager_history_put (BoltManager      *mgr,
+                     const char       *uid,
+                     BoltHistoryEvent  event,
+                     BoltHistoryResult result,
+                     guint32           duration)
+{
+  g_autoptr(GError) err = NULL;
+  gboolean ok;
+
+  if (mgr->history == NULL)
+    return;
+
+  ok = bolt_history_put (mgr->history, uid, event, result, duration, &err);
+
+  if (!ok)
+    bolt_warn_err (err, LOG_DEV_UID (uid), LOG_TOPIC ("history"),
+                   "failed to record %s",
+                   bolt_history_event_to_string (event));
+}
+
+static void
+manager_history_connect (BoltManager *mgr,
+                         BoltDevice  *dev)
+{
+  g_autoptr(GPtrArray) entries = NULL;
+  g_autoptr(GError) err = NULL;
+  const char *uid;
+  guint64 ct;
+
+  if (mgr->history == NULL)
+    return;
+
+  uid = bolt_device_get_uid (dev);
+  ct = bolt_device_get_conntime (dev);
+
+  /* devices that were connected already when we started
+   * might have been recorded by the previous instance; the
+   * connect time is the one of the sysfs directory, so all
+   * records since then belong to the same connection */
+  if (ct > 0)
+    entries = bolt_history_query (mgr->history, uid,
+                                  ct * G_USEC_PER_SEC, 0, 0,
+                                  &err);
+
+  if (err != NULL)
+    bolt_warn_err (err, LOG_DEV (dev), LOG_TOPIC ("history"),
+                   "failed to query history");
+
+  for (guint i = 0; entries && i < entries->len; i++)
+    {
+      BoltHistoryEntry *entry = g_ptr_array_index (entries, i);
+
+      if (entry->event == BOLT_HISTORY_CONNECT)
+        return;
+    }
+
+  manager_history_put (mgr, uid, BOLT_HISTORY_CONNECT,
+                       BOLT_HISTORY_RESULT_NONE, 0);
+}
+
+static void
+manager_history_status (BoltManager *mgr,
+                        BoltDevice  *dev,
+                        BoltStatus   old,
+                        BoltStatus   now)
+{
+  BoltHistoryResult result;
+  gint64 *start;
+  gint64 dt;
+
+  if (mgr->history == NULL)
+    return;
+
+  if (now == BOLT_STATUS_AUTHORIZING)
+    {
+      start = g_new (gint64, 1);
+      *start = bolt_clock_get_time (mgr->clock);
+      g_hash_table_replace (mgr->auth_start, dev, start);
+      return;
+    }
+  else if (old != BOLT_STATUS_AUTHORIZING)
+    {
+      return;
+    }
+
+  start = g_hash_table_lookup (mgr->auth_start, dev);
+  dt = start ? bolt_clock_get_time (mgr->clock) - *start : 0;
+  g_hash_table_remove (mgr->auth_start, dev);
+
+  if (bolt_status_is_authorized (now))
+    result = BOLT_HISTORY_RESULT_OK;
+  else
+    result = BOLT_HISTORY_RESULT_FAILED;
+
+  manager_history_put (mgr, bolt_device_get_uid (dev),
+                       BOLT_HISTORY_AUTHORIZE,
+                       result,
+                       (guint32) MIN (dt / 1000, G_MAXUINT32));
+}
+
+/* idle exit */
+
+/* The activity counter is shared with the dbus message filter,
+ * which runs in the dbus worker thread and might still do so
+ * after it has been removed; the filter thus holds a reference
+ * of its own, dropped via the filter's destroy notify. */
+struct IdleActivity
+{
+  gint ref;
+  gint count;
+};
+
+static IdleActivity *
+idle_activity_new (void)
+{
+  IdleActivity *activity = g_new0 (IdleActivity, 1);
+
+  activity->ref = 1;
+  return activity;
+}
+
+static IdleActivity *
+idle_activity_ref (IdleActivity *activity)
+{
+  g_atomic_int_inc (&activity->ref);
+  return activity;
+}
+
+static void
+idle_activity_unref (gpointer data)
+{
+  IdleActivity *activity = data;
+
+  if (g_atomic_int_dec_and_test (&activity->ref))
+    g_free (activity);
+}
+
+static GDBusMessage *
+manager_idle_filter (GDBusConnection *connection,
+                     GDBusMessage    *message,
+                     gboolean         incoming,
+                     gpointer         user_data)
+{
+  IdleActivity *activity = user_data;
+  GDBusMessageType type;
+
+  /* NB: called from the dbus worker thread */
+  type = g_dbus_message_get_message_type (message);
+
+  if (incoming && type == G_DBUS_MESSAGE_TYPE_METHOD_CALL)
+    g_atomic_int_inc (&activity->count);
+
+  return message;
+}
+
+static gboolean
+manager_is_idle (BoltManager *mgr)
+{
+  BoltPowerState power;
+
+  /* pending work of any kind */
+  if (mgr->authorizing > 0 ||
+      mgr->deferred_source != 0 ||
+      mgr->coalesce_source != 0 ||
+      mgr->storm_source != 0 ||
+      mgr->probing_timeout != 0)
+    return FALSE;
+
+  /* somebody wants the controller to be on */
+  power = bolt_power_get_state (mgr->power);
+  if (power == BOLT_FORCE_POWER_ON ||
+      power == BOLT_FORCE_POWER_WAIT)
+    return FALSE;
+
+  /* the host is always there, peripherals must not */
+  for (guint i = 0; i < mgr->devices->len; i++)
+    {
+      BoltDevice *dev = g_ptr_array_index (mgr->devices, i);
+      BoltStatus status = bolt_device_get_status (dev);
+
+      if (bolt_device_get_device_type (dev) == BOLT_DEVICE_HOST)
+        continue;
+
+      if (status != BOLT_STATUS_DISCONNECTED)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+manager_idle_check (gpointer user_data)
+{
+  BoltManager *mgr = user_data;
+  gint activity;
+
+  /* any activity during the last period, i.e. since
+   * the previous check, or ongoing activity right now
+   * means we are not idle and start a new period */
+  activity = g_atomic_int_get (&mgr->idle_activity->count);
+
+  if (activity != mgr->idle_seen || !manager_is_idle (mgr))
+    {
+      mgr->idle_seen = activity;
+      return G_SOURCE_CONTINUE;
+    }
+
+  bolt_msg (LOG_TOPIC ("idle"), "idle for %u seconds", mgr->idle_timeout);
+
+  mgr->idle_source = 0;
+  g_signal_emit (mgr, signals[SIGNAL_IDLE], 0);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+manager_idle_start (BoltManager *mgr)
+{
+  GDBusConnection *bus;
+
+  bus = bolt_exported_get_connection (BOLT_EXPORTED (mgr));
+
+  if (bus != NULL && mgr->idle_filter == 0)
+    {
+      IdleActivity *activity = idle_activity_ref (mgr->idle_activity);
+
+      mgr->idle_filter = g_dbus_connection_add_filter (bus,
+                                                       manager_idle_filter,
+                                                       activity,
+                                                       idle_activity_unref);
+    }
+
+  mgr->idle_seen = g_atomic_int_get (&mgr->idle_activity->count);
+
+  if (mgr->idle_source == 0)
+    mgr->idle_source = bolt_clock_timeout_add_seconds (mgr->clock,
+                                                       mgr->idle_timeout,
+                                                       manager_idle_check,
+                                                       mgr);
+
+  bolt_info (LOG_TOPIC ("idle"), "exiting after %u idle seconds",
+             mgr->idle_timeout);
+}
+
+static void
+manager_idle_stop (BoltManager *mgr)
+{
+  GDBusConnection *bus;
+
+  if (mgr->idle_source)
+    {
+      bolt_clock_source_remove (mgr->clock, mgr->idle_source);
+      mgr->idle_source = 0;
+    }
+
+  bus = bolt_exported_get_connection (BOLT_EXPORTED (mgr));
+
+  if (bus != NULL && mgr->idle_filter != 0)
+    g_dbus_connection_remove_filter (bus, mgr->idle_filter);
+
+  mgr->idle_filter = 0;
+}
 
 /* config */
 static void
@@ -2009,6 +4417,9 @@ manager_load_user_config (BoltManager *mgr)
   BoltPolicy policy;
   BoltAuthMode authmode;
   BoltTri res;
+  guint window;
+  guint idle;
+  const char *source;
 
   bolt_info (LOG_TOPIC ("config"), "loading user config");
   mgr->config = bolt_store_config_load (mgr->store, &err);
@@ -2036,6 +4447,48 @@ manager_load_user_config (BoltManager *mgr)
       g_object_notify_by_pspec (G_OBJECT (mgr), props[PROP_POLICY]);
     }
 
+  res = bolt_config_load_coalesce_window (mgr->config, &window, &err);
+  if (res == TRI_ERROR)
+    {
+      bolt_warn_err (err, LOG_TOPIC ("config"),
+                     "failed to load coalesce window");
+      g_clear_error (&err);
+    }
+  else if (res == TRI_YES)
+    {
+      bolt_info (LOG_TOPIC ("config"), "coalesce window set to %u ms",
+                 window);
+      mgr->coalesce_window = window;
+    }
+
+  res = bolt_config_load_idle_exit (mgr->config, &idle, &err);
+  if (res == TRI_ERROR)
+    {
+      bolt_warn_err (err, LOG_TOPIC ("config"),
+                     "failed to load idle exit timeout");
+      g_clear_error (&err);
+    }
+  else if (res == TRI_YES)
+    {
+      bolt_info (LOG_TOPIC ("config"), "idle exit timeout set to %u s",
+                 idle);
+      mgr->idle_timeout = idle;
+    }
+
+  res = bolt_config_load_uevent_source (mgr->config, &source, &err);
+  if (res == TRI_ERROR)
+    {
+      bolt_warn_err (err, LOG_TOPIC ("config"),
+                     "failed to load uevent source");
+      g_clear_error (&err);
+    }
+  else if (res == TRI_YES)
+    {
+      bolt_info (LOG_TOPIC ("config"), "uevent source set to '%s'",
+                 source ? : "auto");
+      mgr->uevent_source = source;
+    }
+
   res = bolt_config_load_auth_mode (mgr->config, &authmode, &err);
   if (res == TRI_ERROR)
     {
@@ -2054,6 +4507,89 @@ manager_load_user_config (BoltManager *mgr)
     }
 }
 
+static void
+manager_load_rules (BoltManager *mgr)
+{
+  g_autoptr(GKeyFile) kf = NULL;
+  g_autoptr(GError) err = NULL;
+
+  kf = bolt_store_rules_load (mgr->store, &err);
+  if (kf == NULL)
+    {
+      if (!bolt_err_notfound (err))
+        bolt_warn_err (err, LOG_TOPIC ("rules"),
+                       "failed to load rules");
+      return;
+    }
+
+  mgr->rules = bolt_rules_new_from_keyfile (kf, &err);
+  if (mgr->rules == NULL)
+    {
+      bolt_warn_err (err, LOG_TOPIC ("rules"),
+                     "failed to compile rules, ignoring all");
+      return;
+    }
+
+  bolt_info (LOG_TOPIC ("rules"), "%u rules loaded",
+             bolt_rules_get_count (mgr->rules));
+}
+
+static BoltRuleAction
+manager_rules_match (BoltManager *mgr,
+                     BoltDevice  *dev,
+                     const char **label)
+{
+  BoltRuleQuery query = {NULL, };
+  BoltDomain *domain;
+  BoltDevice *parent;
+  BoltRuleAction action;
+  const char *rule = NULL;
+
+  if (mgr->rules == NULL)
+    return BOLT_RULE_NONE;
+
+  domain = bolt_device_get_domain (dev);
+
+  query.vendor = bolt_device_get_vendor (dev);
+  query.name = bolt_device_get_name (dev);
+  query.type = bolt_device_get_device_type (dev);
+  query.domain = domain ? bolt_domain_get_id (domain) : NULL;
+  query.security = bolt_device_get_security (dev);
+
+  parent = g_hash_table_lookup (mgr->topo_parent, dev);
+  if (parent != NULL)
+    query.parent = bolt_device_get_uid (parent);
+
+  for (; parent != NULL; query.depth++)
+    parent = g_hash_table_lookup (mgr->topo_parent, parent);
+
+  action = bolt_rules_match (mgr->rules, &query, &rule, label);
+
+  /* called several times per event, see manager_rules_apply */
+  if (action != BOLT_RULE_NONE)
+    bolt_debug (LOG_DEV (dev), LOG_TOPIC ("rules"), "matched rule '%s': %s",
+                rule, bolt_rule_action_to_string (action));
+
+  return action;
+}
+
+/* 'deny' is enforced for explicit requests too, i.e. the
+ * Authorize and EnrollDevice methods, not just for the
+ * automatic authorization and import */
+static void
+manager_rules_apply (BoltManager *mgr,
+                     BoltDevice  *dev)
+{
+  BoltRuleAction action;
+
+  action = manager_rules_match (mgr, dev, NULL);
+  bolt_device_set_denied (dev, action == BOLT_RULE_DENY);
+
+  if (action != BOLT_RULE_NONE)
+    bolt_info (LOG_DEV (dev), LOG_TOPIC ("rules"), "rule policy: %s",
+               bolt_rule_action_to_string (action));
+}
+
 /* dbus property setter */
 static gboolean
 handle_set_authmode (BoltExported *obj,
@@ -2165,18 +4701,32 @@ handle_list_devices (BoltExported          *obj,
 {
   BoltManager *mgr = BOLT_MANAGER (obj);
   const char **devs;
+  guint n = 0;
+
+  manager_deferred_flush (mgr);
+
+  /* the list is only rebuilt after the device table
+   * changed, monitoring clients that poll are cheap */
+  if (mgr->devlist != NULL)
+    return g_variant_new ("(@ao)", mgr->devlist);
 
   devs = g_newa (const char *, mgr->devices->len + 1);
 
   for (guint i = 0; i < mgr->devices->len; i++)
     {
       BoltDevice *d = g_ptr_array_index (mgr->devices, i);
-      devs[i] = bolt_device_get_object_path (d);
+      const char *opath = bolt_device_get_object_path (d);
+
+      /* export might still be pending */
+      if (opath != NULL)
+        devs[n++] = opath;
     }
 
-  devs[mgr->devices->len] = NULL;
+  devs[n] = NULL;
 
-  return g_variant_new ("(^ao)", devs);
+  mgr->devlist = g_variant_ref_sink (g_variant_new_objv (devs, n));
+
+  return g_variant_new ("(@ao)", mgr->devlist);
 }
 
 static GVariant *
@@ -2191,6 +4741,7 @@ handle_device_by_uid (BoltExported          *obj,
   const char *opath;
 
   mgr = BOLT_MANAGER (obj);
+  manager_deferred_flush (mgr);
 
   g_variant_get (params, "(&s)", &uid);
   dev = manager_find_device_by_uid (mgr, uid, error);
@@ -2199,6 +4750,15 @@ handle_device_by_uid (BoltExported          *obj,
     return NULL;
 
   opath = bolt_device_get_object_path (dev);
+
+  if (opath == NULL)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                   "device with id '%s' could not be found.",
+                   uid);
+      return NULL;
+    }
+
   return g_variant_new ("(o)", opath);
 }
 
@@ -2291,6 +4851,7 @@ handle_enroll_device (BoltExported          *obj,
   const char *policy;
 
   mgr = BOLT_MANAGER (obj);
+  manager_deferred_flush (mgr);
 
   g_variant_get_child (params, 0, "&s", &uid);
   g_variant_get_child (params, 1, "&s", &policy);
@@ -2320,6 +4881,12 @@ handle_enroll_device (BoltExported          *obj,
                    uid);
       return NULL;
     }
+  else if (bolt_device_is_denied (dev))
+    {
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                   "enrolling device '%s' denied by rule", uid);
+      return NULL;
+    }
 
   /* if the device is already authorized, we just store it */
   if (bolt_device_is_authorized (dev))
@@ -2362,6 +4929,7 @@ handle_forget_device (BoltExported          *obj,
   const char *uid;
 
   mgr = BOLT_MANAGER (obj);
+  manager_deferred_flush (mgr);
 
   g_variant_get (params, "(&s)", &uid);
   dev = manager_find_device_by_uid (mgr, uid, error);
@@ -2374,6 +4942,417 @@ handle_forget_device (BoltExported          *obj,
   return ok ? g_variant_new ("()") : NULL;
 }
 
+typedef struct DeviceQuery
+{
+  GArray      *status;    /* BoltStatus values, or NULL for any */
+  char        *domain;    /* domain uid, or NULL for any */
+  BoltDomain  *dom;       /* the resolved domain, not owned */
+  gint         policy;    /* -1 for any, as the following */
+  gint         stored;
+  gint         type;
+  gint         key;
+  gboolean     conntime;  /* TRUE if the range is set */
+  guint64      ct_range[2];
+  gboolean     authtime;
+  guint64      at_range[2];
+  char       **props;     /* properties to include */
+} DeviceQuery;
+
+static void
+device_query_clear (DeviceQuery *query)
+{
+  g_clear_pointer (&query->status, g_array_unref);
+  g_clear_pointer (&query->domain, g_free);
+  g_clear_pointer (&query->props, g_strfreev);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC (DeviceQuery, device_query_clear);
+
+static gboolean
+device_query_enum_from_string (GType       enum_type,
+                               const char *str,
+                               gint       *out,
+                               GError    **error)
+{
+  g_autoptr(GEnumClass) klass = NULL;
+
+  klass = g_type_class_ref (enum_type);
+
+  return bolt_enum_class_from_string (klass, str, out, error);
+}
+
+static gboolean
+device_query_parse_enum (GType       enum_type,
+                         const char *key,
+                         GVariant   *val,
+                         gint       *out,
+                         GError    **error)
+{
+  const char *str;
+
+  if (!g_variant_is_of_type (val, G_VARIANT_TYPE_STRING))
+    {
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                   "filter '%s' must be a string", key);
+      return FALSE;
+    }
+
+  str = g_variant_get_string (val, NULL);
+
+  return device_query_enum_from_string (enum_type, str, out, error);
+}
+
+static gboolean
+device_query_parse_range (const char *key,
+                          GVariant   *val,
+                          guint64    *range,
+                          GError    **error)
+{
+  if (!g_variant_is_of_type (val, G_VARIANT_TYPE ("(tt)")))
+    {
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                   "filter '%s' must be a time range (tt)", key);
+      return FALSE;
+    }
+
+  g_variant_get (val, "(tt)", &range[0], &range[1]);
+
+  return TRUE;
+}
+
+static gboolean
+device_query_parse (DeviceQuery *query,
+                    GVariant    *filter,
+                    GError     **error)
+{
+  GVariantIter iter;
+  const char *key;
+  GVariant *val;
+
+  query->policy = -1;
+  query->stored = -1;
+  query->type = -1;
+  query->key = -1;
+
+  g_variant_iter_init (&iter, filter);
+  while (g_variant_iter_loop (&iter, "{&sv}", &key, &val))
+    {
+      gboolean ok = TRUE;
+
+      if (g_str_equal (key, "status"))
+        {
+          g_autofree const char **strv = NULL;
+
+          if (!g_variant_is_of_type (val, G_VARIANT_TYPE_STRING_ARRAY))
+            {
+              g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                           "filter 'status' must be a string array");
+              g_variant_unref (val);
+              return FALSE;
+            }
+
+          strv = g_variant_get_strv (val, NULL);
+          g_clear_pointer (&query->status, g_array_unref);
+          query->status = g_array_new (FALSE, FALSE, sizeof (gint));
+
+          for (guint i = 0; ok && strv[i] != NULL; i++)
+            {
+              gint status;
+
+              ok = device_query_enum_from_string (BOLT_TYPE_STATUS,
+                                                  strv[i],
+                                                  &status,
+                                                  error);
+              if (ok)
+                g_array_append_val (query->status, status);
+            }
+        }
+      else if (g_str_equal (key, "domain"))
+        {
+          ok = g_variant_is_of_type (val, G_VARIANT_TYPE_STRING);
+
+          if (ok)
+            {
+              g_free (query->domain);
+              query->domain = g_variant_dup_string (val, NULL);
+            }
+          else
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                         "filter 'domain' must be a string");
+        }
+      else if (g_str_equal (key, "policy"))
+        {
+          ok = device_query_parse_enum (BOLT_TYPE_POLICY, key, val,
+                                        &query->policy, error);
+        }
+      else if (g_str_equal (key, "type"))
+        {
+          ok = device_query_parse_enum (BOLT_TYPE_DEVICE_TYPE, key, val,
+                                        &query->type, error);
+        }
+      else if (g_str_equal (key, "key"))
+        {
+          ok = device_query_parse_enum (BOLT_TYPE_KEY_STATE, key, val,
+                                        &query->key, error);
+        }
+      else if (g_str_equal (key, "stored"))
+        {
+          ok = g_variant_is_of_type (val, G_VARIANT_TYPE_BOOLEAN);
+
+          if (ok)
+            query->stored = g_variant_get_boolean (val);
+          else
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                         "filter 'stored' must be a boolean");
+        }
+      else if (g_str_equal (key, "conntime"))
+        {
+          ok = device_query_parse_range (key, val, query->ct_range, error);
+          query->conntime = ok;
+        }
+      else if (g_str_equal (key, "authtime"))
+        {
+          ok = device_query_parse_range (key, val, query->at_range, error);
+          query->authtime = ok;
+        }
+      else if (g_str_equal (key, "properties"))
+        {
+          ok = g_variant_is_of_type (val, G_VARIANT_TYPE_STRING_ARRAY);
+
+          if (ok)
+            {
+              g_strfreev (query->props);
+              query->props = g_variant_dup_strv (val, NULL);
+            }
+          else
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                         "filter 'properties' must be a string array");
+        }
+      else
+        {
+          g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                       "unknown filter: '%s'", key);
+          ok = FALSE;
+        }
+
+      if (!ok)
+        {
+          g_variant_unref (val);
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+device_query_match (const DeviceQuery *query,
+                    BoltDevice        *dev)
+{
+  guint64 t;
+
+  if (query->status != NULL)
+    {
+      gint status = bolt_device_get_status (dev);
+      gboolean found = FALSE;
+
+      for (guint i = 0; !found && i < query->status->len; i++)
+        found = g_array_index (query->status, gint, i) == status;
+
+      if (!found)
+        return FALSE;
+    }
+
+  if (query->domain != NULL &&
+      bolt_device_get_domain (dev) != query->dom)
+    return FALSE;
+
+  if (query->policy > -1 &&
+      (gint) bolt_device_get_policy (dev) != query->policy)
+    return FALSE;
+
+  if (query->stored > -1 &&
+      bolt_device_get_stored (dev) != query->stored)
+    return FALSE;
+
+  if (query->type > -1 &&
+      (gint) bolt_device_get_device_type (dev) != query->type)
+    return FALSE;
+
+  if (query->key > -1 &&
+      (gint) bolt_device_get_keystate (dev) != query->key)
+    return FALSE;
+
+  t = bolt_device_get_conntime (dev);
+  if (query->conntime &&
+      (t < query->ct_range[0] || t > query->ct_range[1]))
+    return FALSE;
+
+  t = bolt_device_get_authtime (dev);
+  if (query->authtime &&
+      (t < query->at_range[0] || t > query->at_range[1]))
+    return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+device_query_add_result (const DeviceQuery *query,
+                         BoltDevice        *dev,
+                         GVariantBuilder   *builder,
+                         GError           **error)
+{
+  GVariantBuilder props;
+  const char *opath;
+
+  opath = bolt_device_get_object_path (dev);
+
+  /* not exported (yet), so not visible to clients */
+  if (opath == NULL)
+    return TRUE;
+
+  g_variant_builder_init (&props, G_VARIANT_TYPE_VARDICT);
+
+  for (guint i = 0; query->props && query->props[i]; i++)
+    {
+      g_autoptr(GVariant) val = NULL;
+      const char *name = query->props[i];
+
+      val = bolt_exported_get_prop_value (BOLT_EXPORTED (dev), name, error);
+
+      if (val == NULL)
+        {
+          g_variant_builder_clear (&props);
+          return FALSE;
+        }
+
+      g_variant_builder_add (&props, "{sv}", name, val);
+    }
+
+  g_variant_builder_add (builder, "(oa{sv})", opath, &props);
+
+  return TRUE;
+}
+
+static GVariant *
+handle_query_devices (BoltExported          *obj,
+                      GVariant              *params,
+                      GDBusMethodInvocation *inv,
+                      GError               **error)
+{
+  g_auto(DeviceQuery) query = {NULL, };
+  g_autoptr(GVariant) filter = NULL;
+  GVariantBuilder builder;
+  BoltManager *mgr;
+  gboolean ok;
+
+  mgr = BOLT_MANAGER (obj);
+  manager_deferred_flush (mgr);
+
+  g_variant_get (params, "(@a{sv})", &filter);
+
+  ok = device_query_parse (&query, filter, error);
+  if (!ok)
+    return NULL;
+
+  /* the indexes are used to rule out queries that cannot
+   * match anything; otherwise the device list is filtered,
+   * so the result has the same order as ListDevices */
+  if (query.domain != NULL)
+    {
+      query.dom = bolt_domain_find_id (mgr->domains, query.domain, NULL);
+
+      if (query.dom == NULL)
+        return g_variant_new ("(a(oa{sv}))", NULL);
+    }
+
+  if (query.status != NULL)
+    {
+      guint n = 0;
+
+      for (guint i = 0; i < query.status->len; i++)
+        {
+          gint status = g_array_index (query.status, gint, i);
+          GHashTable *bucket;
+
+          bucket = g_hash_table_lookup (mgr->status_index,
+                                        GINT_TO_POINTER (status));
+          if (bucket != NULL)
+            n += g_hash_table_size (bucket);
+        }
+
+      if (n == 0)
+        return g_variant_new ("(a(oa{sv}))", NULL);
+    }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(oa{sv})"));
+
+  for (guint i = 0; i < mgr->devices->len; i++)
+    {
+      BoltDevice *dev = g_ptr_array_index (mgr->devices, i);
+
+      if (!device_query_match (&query, dev))
+        continue;
+
+      ok = device_query_add_result (&query, dev, &builder, error);
+
+      if (!ok)
+        {
+          g_variant_builder_clear (&builder);
+          return NULL;
+        }
+    }
+
+  return g_variant_new ("(a(oa{sv}))", &builder);
+}
+
+static GVariant *
+handle_get_history (BoltExported          *obj,
+                    GVariant              *params,
+                    GDBusMethodInvocation *inv,
+                    GError               **error)
+{
+  g_autoptr(GPtrArray) entries = NULL;
+  GVariantBuilder builder;
+  BoltManager *mgr;
+  const char *uid;
+  guint64 since;
+  guint64 until;
+  guint limit;
+
+  mgr = BOLT_MANAGER (obj);
+
+  if (mgr->history == NULL)
+    {
+      g_set_error_literal (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                           "device history not available");
+      return NULL;
+    }
+
+  g_variant_get (params, "(&sttu)", &uid, &since, &until, &limit);
+
+  entries = bolt_history_query (mgr->history, uid, since, until, limit, error);
+
+  if (entries == NULL)
+    return NULL;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(tsssu)"));
+
+  for (guint i = 0; i < entries->len; i++)
+    {
+      BoltHistoryEntry *entry = g_ptr_array_index (entries, i);
+
+      g_variant_builder_add (&builder, "(tsssu)",
+                             entry->ts,
+                             entry->uid,
+                             bolt_history_event_to_string (entry->event),
+                             bolt_history_result_to_string (entry->result),
+                             entry->duration);
+    }
+
+  return g_variant_new ("(a(tsssu))", &builder);
+}
+
 /* public methods */
 gboolean
 bolt_manager_export (BoltManager     *mgr,
@@ -2458,4 +5437,7 @@ bolt_manager_got_the_name (BoltManager *mgr)
                                  g_variant_new ("(o)", opath),
                                  NULL);
     }
+
+  if (mgr->idle_timeout > 0)
+    manager_idle_start (mgr);
 }
@@ -33,4 +33,8 @@ gboolean         bolt_manager_export (BoltManager     *mgr,
 
 void             bolt_manager_got_the_name (BoltManager *mgr);
 
+void             bolt_manager_save_snapshot (BoltManager *mgr);
+
+gboolean         bolt_manager_is_busy (BoltManager *mgr);
+
 G_END_DECLS
@@ -22,6 +22,7 @@
 
 #include "bolt-power.h"
 
+#include "bolt-clock.h"
 #include "bolt-enums.h"
 #include "bolt-error.h"
 #include "bolt-fs.h"
@@ -573,10 +574,9 @@ static gboolean bolt_power_wait_timeout (gpointer user_data);
 static gboolean bolt_power_reaper_timeout (gpointer user_data);
 
 
-static void     handle_uevent_udev (BoltUdev           *udev,
-                                    const char         *action,
-                                    struct udev_device *device,
-                                    gpointer            user_data);
+static void     handle_uevent_batch_udev (BoltUdev  *udev,
+                                          GPtrArray *batch,
+                                          gpointer   user_data);
 
 /* dbus methods */
 static GVariant *  handle_list_guards (BoltExported          *object,
@@ -601,6 +601,9 @@ struct _BoltPower
   /* connection to udev */
   BoltUdev *udev;
 
+  /* source of time and timeouts */
+  BoltClock *clock;
+
   /* the path to the sysfs device file,
    * or NULL if force power is unavailable */
   char          *path;
@@ -622,6 +625,7 @@ enum {
   PROP_RUNDIR,
   PROP_STATEDIR,
   PROP_UDEV,
+  PROP_CLOCK,
   PROP_SUPPORTED,
   PROP_STATE,
   PROP_TIMEOUT,
@@ -644,12 +648,14 @@ bolt_power_finalize (GObject *object)
 
   if (power->wait_id != 0)
     {
-      g_source_remove (power->wait_id);
+      bolt_clock_source_remove (power->clock, power->wait_id);
       bolt_power_wait_timeout (power);
     }
 
   if (power->reaper != 0)
-    g_source_remove (power->reaper);
+    bolt_clock_source_remove (power->clock, power->reaper);
+
+  g_clear_object (&power->clock);
 
   g_clear_pointer (&power->runpath, g_free);
   g_clear_object (&power->statedir);
@@ -667,6 +673,7 @@ bolt_power_init (BoltPower *power)
 {
   power->state = BOLT_FORCE_POWER_UNSET;
   power->guards = g_hash_table_new (g_str_hash, g_str_equal);
+  power->clock = g_object_ref (bolt_clock_get_default ());
 }
 
 static void
@@ -692,6 +699,10 @@ bolt_power_get_property (GObject    *object,
       g_value_set_object (value, power->udev);
       break;
 
+    case PROP_CLOCK:
+      g_value_set_object (value, power->clock);
+      break;
+
     case PROP_SUPPORTED:
       g_value_set_boolean (value, power->path != NULL);
       break;
@@ -727,6 +738,11 @@ bolt_power_set_property (GObject      *object,
       power->udev = g_value_dup_object (value);
       break;
 
+    case PROP_CLOCK:
+      if (g_value_get_object (value) != NULL)
+        g_set_object (&power->clock, g_value_get_object (value));
+      break;
+
     case PROP_TIMEOUT:
       power->timeout = g_value_get_uint (value);
       break;
@@ -771,6 +787,14 @@ bolt_power_class_init (BoltPowerClass *klass)
                          G_PARAM_CONSTRUCT_ONLY |
                          G_PARAM_STATIC_STRINGS);
 
+  power_props[PROP_CLOCK] =
+    g_param_spec_object ("clock",
+                         NULL, NULL,
+                         BOLT_TYPE_CLOCK,
+                         G_PARAM_READWRITE |
+                         G_PARAM_CONSTRUCT_ONLY |
+                         G_PARAM_STATIC_STRINGS);
+
   power_props[PROP_SUPPORTED] =
     g_param_spec_boolean ("supported",
                           "Supported", NULL,
@@ -845,8 +869,8 @@ bolt_power_initialize (GInitable    *initable,
                    "failed to create guarddir at %s", statedir);
   g_clear_error (&err);
 
-  g_signal_connect_object (power->udev, "uevent",
-                           (GCallback) handle_uevent_udev,
+  g_signal_connect_object (power->udev, "uevent-batch",
+                           (GCallback) handle_uevent_batch_udev,
                            power, 0);
 
   ok = bolt_udev_detect_force_power (power->udev, &power->path, &err);
@@ -1118,31 +1142,47 @@ handle_uevent_wmi (BoltPower          *power,
 }
 
 static void
-handle_uevent_udev (BoltUdev           *udev,
-                    const char         *action,
-                    struct udev_device *device,
-                    gpointer            user_data)
+handle_uevent_batch_udev (BoltUdev  *udev,
+                          GPtrArray *batch,
+                          gpointer   user_data)
 {
   BoltPower *power = BOLT_POWER (user_data);
-  const char *subsystem;
+  struct udev_device *tb_added = NULL;
+  struct udev_device *wmi_changed = NULL;
+
+  /* resetting the timeout and re-detecting force power
+   * support is only needed once per batch */
+  for (guint i = 0; i < batch->len; i++)
+    {
+      struct udev_device *device = g_ptr_array_index (batch, i);
+      const char *subsystem = udev_device_get_subsystem (device);
+      const char *action = udev_device_get_action (device);
+
+      if (bolt_streq (subsystem, "thunderbolt") && bolt_streq (action, "add"))
+        tb_added = device;
+      else if (bolt_streq (subsystem, "wmi") && bolt_streq (action, "change"))
+        wmi_changed = device;
+      else if (bolt_streq (subsystem, "wmi"))
+        handle_uevent_wmi (power, action, device);
+    }
 
-  subsystem = udev_device_get_subsystem (device);
+  if (tb_added != NULL)
+    handle_uevent_thunderbolt (power, "add", tb_added);
 
-  if (bolt_streq (subsystem, "thunderbolt"))
-    handle_uevent_thunderbolt (power, action, device);
-  else if (bolt_streq (subsystem, "wmi"))
-    handle_uevent_wmi (power, action, device);
+  if (wmi_changed != NULL)
+    handle_uevent_wmi (power, "change", wmi_changed);
 }
 
 static void
 bolt_power_timeout_reset (BoltPower *power)
 {
   if (power->wait_id > 0)
-    g_source_remove (power->wait_id);
+    bolt_clock_source_remove (power->clock, power->wait_id);
 
-  power->wait_id = g_timeout_add (power->timeout,
-                                  bolt_power_wait_timeout,
-                                  power);
+  power->wait_id = bolt_clock_timeout_add (power->clock,
+                                           power->timeout,
+                                           bolt_power_wait_timeout,
+                                           power);
 
   if (power->state != BOLT_FORCE_POWER_WAIT)
     {
@@ -1368,13 +1408,17 @@ handle_list_guards (BoltExported          *object,
 
 /* public methods */
 BoltPower *
-bolt_power_new (BoltUdev *udev)
+bolt_power_new (BoltUdev   *udev,
+                BoltClock  *clk,
+                const char *rundir)
 {
   BoltPower *power;
 
   power = g_initable_new (BOLT_TYPE_POWER,
                           NULL, NULL,
                           "udev", udev,
+                          "clock", clk,
+                          "rundir", rundir ? : DEFAULT_RUNDIR,
                           NULL);
 
   return power;
@@ -1442,7 +1486,7 @@ bolt_power_acquire_full (BoltPower  *power,
 
   if (power->state == BOLT_FORCE_POWER_WAIT)
     {
-      g_source_remove (power->wait_id);
+      bolt_clock_source_remove (power->clock, power->wait_id);
       power->wait_id = 0;
       power->state = BOLT_FORCE_POWER_ON;
       g_object_notify_by_pspec (G_OBJECT (power),
@@ -1479,9 +1523,10 @@ bolt_power_acquire_full (BoltPower  *power,
              guard->id, guard->who);
 
   if (power->reaper == 0)
-    power->reaper = g_timeout_add_seconds (POWER_REAPER_TIMEOUT,
-                                           bolt_power_reaper_timeout,
-                                           power);
+    power->reaper = bolt_clock_timeout_add_seconds (power->clock,
+                                                    POWER_REAPER_TIMEOUT,
+                                                    bolt_power_reaper_timeout,
+                                                    power);
 
   /* guard is saved so we can recover our state if we
    * were to crash or restarted */
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "bolt-clock.h"
 #include "bolt-enums.h"
 #include "bolt-exported.h"
 #include "bolt-udev.h"
@@ -50,7 +51,9 @@ guint               bolt_power_guard_get_pid (BoltPowerGuard *guard);
 #define BOLT_TYPE_POWER bolt_power_get_type ()
 G_DECLARE_FINAL_TYPE (BoltPower, bolt_power, BOLT, POWER, BoltExported);
 
-BoltPower  *        bolt_power_new (BoltUdev *udev);
+BoltPower  *        bolt_power_new (BoltUdev   *udev,
+                                    BoltClock  *clk,
+                                    const char *rundir);
 
 GFile *             bolt_power_get_statedir (BoltPower *power);
 
@@ -0,0 +1,497 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "bolt-error.h"
+#include "bolt-log.h"
+#include "bolt-str.h"
+
+#include "bolt-rules.h"
+
+#include <string.h>
+
+#define RULE_GROUP_PREFIX "rule "
+
+/* the fields a rule can match on, in the order they
+ * are checked when walking down the match trie */
+typedef enum RuleField {
+
+  RULE_FIELD_PARENT = 0,
+  RULE_FIELD_VENDOR,
+  RULE_FIELD_NAME,
+  RULE_FIELD_TYPE,
+  RULE_FIELD_DOMAIN,
+  RULE_FIELD_SECURITY,
+  RULE_FIELD_DEPTH,
+
+  RULE_FIELD_LAST
+
+} RuleField;
+
+static const char *rule_field_keys[RULE_FIELD_LAST] = {
+  "Parent",
+  "Vendor",
+  "Name",
+  "Type",
+  "Domain",
+  "Security",
+  "Depth",
+};
+
+static const char *rule_action_names[] = {
+  "none",
+  "auto",
+  "manual",
+  "deny",
+  "label",
+};
+
+typedef struct Rule
+{
+  char          *name;
+  BoltRuleAction action;
+  char          *label;
+} Rule;
+
+/* One level of the match trie per field: a hash table for
+ * the rules that want an exact value and a single branch
+ * for all the rules that do not care about the field. The
+ * leaves hold the index of the first rule that ends there.
+ * Matching visits at most two branches per level and is
+ * thus independent of the number of rules. */
+typedef struct RuleNode RuleNode;
+struct RuleNode
+{
+  GHashTable *exact;  /* value -> RuleNode */
+  RuleNode   *any;
+  guint       first;  /* lowest rule index in the sub-trie */
+  gint        rule;   /* leaf only, -1 if unset */
+};
+
+/* Labels are independent of the policy: a rule that only
+ * sets a label must not hide a later rule with a policy
+ * action, and vice versa, hence there is one trie for each */
+struct _BoltRules
+{
+  GObject object;
+
+  GPtrArray *rules;
+  RuleNode  *root;    /* rules with a policy action */
+  RuleNode  *labels;  /* rules with a label */
+};
+
+
+G_DEFINE_TYPE (BoltRules,
+               bolt_rules,
+               G_TYPE_OBJECT)
+
+
+static void
+rule_free (gpointer data)
+{
+  Rule *rule = data;
+
+  g_free (rule->name);
+  g_free (rule->label);
+  g_slice_free (Rule, rule);
+}
+
+static void
+rule_node_free (gpointer data)
+{
+  RuleNode *node = data;
+
+  if (node == NULL)
+    return;
+
+  g_clear_pointer (&node->exact, g_hash_table_unref);
+  rule_node_free (node->any);
+  g_slice_free (RuleNode, node);
+}
+
+static RuleNode *
+rule_node_new (guint first)
+{
+  RuleNode *node;
+
+  node = g_slice_new0 (RuleNode);
+  node->first = first;
+  node->rule = -1;
+
+  return node;
+}
+
+static RuleNode *
+rule_node_child (RuleNode   *node,
+                 const char *value,
+                 guint       index)
+{
+  RuleNode *child;
+
+  if (value == NULL)
+    {
+      if (node->any == NULL)
+        node->any = rule_node_new (index);
+
+      return node->any;
+    }
+
+  if (node->exact == NULL)
+    node->exact = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, rule_node_free);
+
+  child = g_hash_table_lookup (node->exact, value);
+
+  if (child == NULL)
+    {
+      child = rule_node_new (index);
+      g_hash_table_insert (node->exact, g_strdup (value), child);
+    }
+
+  return child;
+}
+
+static gint
+rule_node_match (RuleNode           *node,
+                 const char * const *values,
+                 guint               level,
+                 gint                best)
+{
+  /* nothing in here can beat what we already have */
+  if (node == NULL || (best > -1 && node->first >= (guint) best))
+    return best;
+
+  if (level == RULE_FIELD_LAST)
+    return node->rule;
+
+  if (node->exact != NULL && values[level] != NULL)
+    {
+      RuleNode *child = g_hash_table_lookup (node->exact, values[level]);
+      best = rule_node_match (child, values, level + 1, best);
+    }
+
+  return rule_node_match (node->any, values, level + 1, best);
+}
+
+static void
+bolt_rules_finalize (GObject *object)
+{
+  BoltRules *rules = BOLT_RULES (object);
+
+  g_ptr_array_unref (rules->rules);
+  rule_node_free (rules->root);
+  rule_node_free (rules->labels);
+
+  G_OBJECT_CLASS (bolt_rules_parent_class)->finalize (object);
+}
+
+static void
+bolt_rules_init (BoltRules *rules)
+{
+  rules->rules = g_ptr_array_new_with_free_func (rule_free);
+  rules->root = rule_node_new (0);
+  rules->labels = rule_node_new (0);
+}
+
+static void
+bolt_rules_class_init (BoltRulesClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = bolt_rules_finalize;
+}
+
+/* compilation */
+static void
+rules_insert (BoltRules  *rules,
+              RuleNode   *root,
+              char      **values,
+              guint       index)
+{
+  RuleNode *node = root;
+  Rule *rule;
+
+  for (guint i = 0; i < RULE_FIELD_LAST; i++)
+    node = rule_node_child (node, values[i], index);
+
+  if (node->rule > -1)
+    {
+      Rule *prev = g_ptr_array_index (rules->rules, node->rule);
+      rule = g_ptr_array_index (rules->rules, index);
+      bolt_warn (LOG_TOPIC ("rules"), "rule '%s' is shadowed by '%s'",
+                 rule->name, prev->name);
+    }
+  else
+    {
+      node->rule = (gint) index;
+    }
+}
+
+static char *
+rule_value_normalize (RuleField   field,
+                      const char *str,
+                      GError    **error)
+{
+  GEnumClass *klass;
+  const char *nick;
+  gboolean ok;
+  GType type;
+  gint val;
+
+  switch (field)
+    {
+    case RULE_FIELD_TYPE:
+      type = BOLT_TYPE_DEVICE_TYPE;
+      break;
+
+    case RULE_FIELD_SECURITY:
+      type = BOLT_TYPE_SECURITY;
+      break;
+
+    case RULE_FIELD_DEPTH:
+      ok = bolt_str_parse_as_int (str, &val);
+      if (!ok || val < 0)
+        {
+          g_set_error (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                       "invalid depth: %s", str);
+          return NULL;
+        }
+      return g_strdup_printf ("%d", val);
+
+    default:
+      return g_strdup (str);
+    }
+
+  klass = g_type_class_ref (type);
+  ok = bolt_enum_class_from_string (klass, str, &val, error);
+  g_type_class_unref (klass);
+
+  if (!ok)
+    return NULL;
+
+  /* match against the canonical nick */
+  nick = bolt_enum_to_string (type, val, error);
+  return g_strdup (nick);
+}
+
+static gboolean
+rules_compile_one (BoltRules  *rules,
+                   GKeyFile   *kf,
+                   const char *group,
+                   GError    **error)
+{
+  g_auto(GStrv) keys = NULL;
+  g_autofree char *label = NULL;
+  char *values[RULE_FIELD_LAST] = {NULL, };
+  BoltRuleAction action = BOLT_RULE_NONE;
+  gboolean ok = FALSE;
+  guint index;
+  Rule *rule;
+
+  keys = g_key_file_get_keys (kf, group, NULL, error);
+  if (keys == NULL)
+    return FALSE;
+
+  for (guint i = 0; keys[i] != NULL; i++)
+    {
+      g_autofree char *str = NULL;
+      const char *key = keys[i];
+      guint field;
+
+      str = g_key_file_get_string (kf, group, key, error);
+      if (str == NULL)
+        goto out;
+
+      if (g_str_equal (key, "Action"))
+        {
+          for (guint k = 1; k < G_N_ELEMENTS (rule_action_names); k++)
+            if (g_str_equal (str, rule_action_names[k]))
+              action = k;
+
+          if (action == BOLT_RULE_NONE)
+            {
+              g_set_error (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                           "invalid action: %s", str);
+              goto out;
+            }
+
+          continue;
+        }
+      else if (g_str_equal (key, "Label"))
+        {
+          bolt_set_str (&label, g_steal_pointer (&str));
+          continue;
+        }
+
+      for (field = 0; field < RULE_FIELD_LAST; field++)
+        if (g_str_equal (key, rule_field_keys[field]))
+          break;
+
+      if (field == RULE_FIELD_LAST)
+        {
+          g_set_error (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                       "unknown key: %s", key);
+          goto out;
+        }
+
+      g_free (values[field]);
+      values[field] = rule_value_normalize (field, str, error);
+
+      if (values[field] == NULL)
+        goto out;
+    }
+
+  if (action == BOLT_RULE_NONE)
+    {
+      g_set_error_literal (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                           "missing action");
+      goto out;
+    }
+  else if (action == BOLT_RULE_LABEL && label == NULL)
+    {
+      g_set_error_literal (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                           "label action without a label");
+      goto out;
+    }
+
+  index = rules->rules->len;
+
+  rule = g_slice_new0 (Rule);
+  rule->name = g_strdup (group + strlen (RULE_GROUP_PREFIX));
+  rule->action = action;
+  rule->label = g_steal_pointer (&label);
+  g_ptr_array_add (rules->rules, rule);
+
+  if (rule->action != BOLT_RULE_LABEL)
+    rules_insert (rules, rules->root, values, index);
+
+  if (rule->label != NULL)
+    rules_insert (rules, rules->labels, values, index);
+
+  ok = TRUE;
+
+out:
+  for (guint i = 0; i < RULE_FIELD_LAST; i++)
+    g_free (values[i]);
+
+  return ok;
+}
+
+/* public methods */
+
+const char *
+bolt_rule_action_to_string (BoltRuleAction action)
+{
+  g_return_val_if_fail (action < G_N_ELEMENTS (rule_action_names), NULL);
+
+  return rule_action_names[action];
+}
+
+BoltRules *
+bolt_rules_new_from_keyfile (GKeyFile *kf,
+                             GError  **error)
+{
+  g_autoptr(BoltRules) rules = NULL;
+  g_auto(GStrv) groups = NULL;
+
+  g_return_val_if_fail (kf != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  rules = g_object_new (BOLT_TYPE_RULES, NULL);
+  groups = g_key_file_get_groups (kf, NULL);
+
+  for (guint i = 0; groups[i] != NULL; i++)
+    {
+      const char *group = groups[i];
+      gboolean ok;
+
+      if (!g_str_has_prefix (group, RULE_GROUP_PREFIX))
+        {
+          g_set_error (error, BOLT_ERROR, BOLT_ERROR_CFG,
+                       "invalid group: %s", group);
+          return NULL;
+        }
+
+      ok = rules_compile_one (rules, kf, group, error);
+      if (!ok)
+        {
+          g_prefix_error (error, "%s: ", group);
+          return NULL;
+        }
+    }
+
+  return g_steal_pointer (&rules);
+}
+
+guint
+bolt_rules_get_count (BoltRules *rules)
+{
+  g_return_val_if_fail (BOLT_IS_RULES (rules), 0);
+
+  return rules->rules->len;
+}
+
+BoltRuleAction
+bolt_rules_match (BoltRules           *rules,
+                  const BoltRuleQuery *query,
+                  const char         **rule,
+                  const char         **label)
+{
+  const char *values[RULE_FIELD_LAST];
+  char depth[16];
+  Rule *r;
+  Rule *l;
+  gint index;
+
+  g_return_val_if_fail (BOLT_IS_RULES (rules), BOLT_RULE_NONE);
+  g_return_val_if_fail (query != NULL, BOLT_RULE_NONE);
+
+  g_snprintf (depth, sizeof (depth), "%u", query->depth);
+
+  values[RULE_FIELD_PARENT] = query->parent;
+  values[RULE_FIELD_VENDOR] = query->vendor;
+  values[RULE_FIELD_NAME] = query->name;
+  values[RULE_FIELD_TYPE] = bolt_device_type_to_string (query->type);
+  values[RULE_FIELD_DOMAIN] = query->domain;
+  values[RULE_FIELD_SECURITY] = bolt_security_to_string (query->security);
+  values[RULE_FIELD_DEPTH] = depth;
+
+  index = rule_node_match (rules->root, values, 0, -1);
+  r = index > -1 ? g_ptr_array_index (rules->rules, index) : NULL;
+
+  index = rule_node_match (rules->labels, values, 0, -1);
+  l = index > -1 ? g_ptr_array_index (rules->rules, index) : NULL;
+
+  if (label)
+    *label = l ? l->label : NULL;
+
+  /* only a label rule matched */
+  if (r == NULL)
+    r = l;
+
+  if (r == NULL)
+    return BOLT_RULE_NONE;
+
+  if (rule)
+    *rule = r->name;
+
+  return r->action;
+}
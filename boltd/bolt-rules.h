@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#pragma once
+
+#include "bolt-enums.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef enum BoltRuleAction {
+
+  BOLT_RULE_NONE = 0,  /* no rule matched */
+  BOLT_RULE_AUTO,      /* authorize automatically */
+  BOLT_RULE_MANUAL,    /* never authorize automatically */
+  BOLT_RULE_DENY,      /* never authorize, never import */
+  BOLT_RULE_LABEL,     /* only apply the label */
+
+} BoltRuleAction;
+
+const char *     bolt_rule_action_to_string (BoltRuleAction action);
+
+/* the properties of a device a rule can match on */
+typedef struct BoltRuleQuery
+{
+  const char    *parent;    /* uid of the parent device */
+  const char    *vendor;
+  const char    *name;
+  BoltDeviceType type;
+  const char    *domain;    /* id of the domain */
+  BoltSecurity   security;
+  guint          depth;     /* 0 for the host */
+} BoltRuleQuery;
+
+/* BoltRules - compiled device policy rules */
+#define BOLT_TYPE_RULES bolt_rules_get_type ()
+G_DECLARE_FINAL_TYPE (BoltRules, bolt_rules, BOLT, RULES, GObject);
+
+BoltRules *      bolt_rules_new_from_keyfile (GKeyFile *kf,
+                                              GError  **error);
+
+guint            bolt_rules_get_count (BoltRules *rules);
+
+BoltRuleAction   bolt_rules_match (BoltRules           *rules,
+                                   const BoltRuleQuery *query,
+                                   const char         **rule,
+                                   const char         **label);
+
+G_END_DECLS
@@ -31,9 +31,30 @@
 
 #include <string.h>
 
+#define STORE_QUEUE_MAX 256 /* pending time stamp writes */
+
 /* ************************************  */
 /* BoltStore */
 
+typedef struct StoreTimeOp
+{
+  char   *uid;
+  char   *timesel;
+  guint64 val;
+} StoreTimeOp;
+
+static void      store_time_op_free (StoreTimeOp *op);
+
+static gboolean  store_write_time (BoltStore  *store,
+                                   const char *uid,
+                                   const char *timesel,
+                                   guint64     val,
+                                   GError    **error);
+
+static void      store_writer_stop (BoltStore *store);
+
+static void      store_writer_sync (BoltStore *store);
+
 struct _BoltStore
 {
   GObject object;
@@ -43,6 +64,15 @@ struct _BoltStore
   GFile  *devices;
   GFile  *keys;
   GFile  *times;
+
+  /* writer thread for the time stamps, see
+   * bolt_store_queue_times () */
+  GMutex   wlock;
+  GCond    wcond;
+  GQueue   wqueue;     /* StoreTimeOp, protected by wlock */
+  GThread *writer;
+  gboolean wbusy;      /* an op is being written */
+  gboolean wquit;
 };
 
 
@@ -76,6 +106,8 @@ bolt_store_finalize (GObject *object)
 {
   BoltStore *store = BOLT_STORE (object);
 
+  store_writer_stop (store);
+
   g_clear_object (&store->root);
   g_clear_object (&store->domains);
   g_clear_object (&store->devices);
@@ -88,6 +120,9 @@ bolt_store_finalize (GObject *object)
 static void
 bolt_store_init (BoltStore *store)
 {
+  g_mutex_init (&store->wlock);
+  g_cond_init (&store->wcond);
+  g_queue_init (&store->wqueue);
 }
 
 static void
@@ -189,6 +224,7 @@ bolt_store_class_init (BoltStoreClass *klass)
 #define USER_GROUP "user"
 
 #define CFG_FILE "boltd.conf"
+#define RULES_FILE "boltd.rules"
 
 /* public methods */
 
@@ -206,9 +242,10 @@ bolt_store_new (const char *path)
   return store;
 }
 
-GKeyFile *
-bolt_store_config_load (BoltStore *store,
-                        GError   **error)
+static GKeyFile *
+store_load_keyfile (BoltStore  *store,
+                    const char *name,
+                    GError    **error)
 {
   g_autoptr(GKeyFile) kf = NULL;
   g_autoptr(GFile) sf = NULL;
@@ -216,10 +253,7 @@ bolt_store_config_load (BoltStore *store,
   gboolean ok;
   gsize len;
 
-  g_return_val_if_fail (store != NULL, NULL);
-  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
-
-  sf = g_file_get_child (store->root, CFG_FILE);
+  sf = g_file_get_child (store->root, name);
   ok = g_file_load_contents (sf, NULL,
                              &data, &len,
                              NULL,
@@ -237,6 +271,16 @@ bolt_store_config_load (BoltStore *store,
   return g_steal_pointer (&kf);
 }
 
+GKeyFile *
+bolt_store_config_load (BoltStore *store,
+                        GError   **error)
+{
+  g_return_val_if_fail (store != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return store_load_keyfile (store, CFG_FILE, error);
+}
+
 gboolean
 bolt_store_config_save (BoltStore *store,
                         GKeyFile  *config,
@@ -267,6 +311,16 @@ bolt_store_config_save (BoltStore *store,
   return ok;
 }
 
+GKeyFile *
+bolt_store_rules_load (BoltStore *store,
+                       GError   **error)
+{
+  g_return_val_if_fail (store != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return store_load_keyfile (store, RULES_FILE, error);
+}
+
 GStrv
 bolt_store_list_uids (BoltStore  *store,
                       const char *type,
@@ -745,6 +799,9 @@ bolt_store_get_time (BoltStore  *store,
   g_return_val_if_fail (timesel != NULL, FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+  /* make sure queued writes are visible */
+  store_writer_sync (store);
+
   fn = g_strdup_printf ("%s.%s", uid, timesel);
   gf = g_file_get_child (store->times, fn);
 
@@ -808,25 +865,14 @@ bolt_store_put_time (BoltStore  *store,
                      guint64     val,
                      GError    **error)
 {
-  g_autoptr(GFile) gf = NULL;
-  g_autofree char *fn = NULL;
-  gboolean ok;
-
   g_return_val_if_fail (BOLT_IS_STORE (store), FALSE);
   g_return_val_if_fail (uid != NULL, FALSE);
   g_return_val_if_fail (timesel != NULL, FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  fn = g_strdup_printf ("%s.%s", uid, timesel);
-  gf = g_file_get_child (store->times, fn);
-
-  ok = bolt_fs_make_parent_dirs (gf, error);
-  if (!ok)
-    return FALSE;
-
-  ok = bolt_fs_touch (gf, val, val, error);
+  store_writer_sync (store);
 
-  return ok;
+  return store_write_time (store, uid, timesel, val, error);
 }
 
 gboolean
@@ -884,6 +930,185 @@ bolt_store_put_times (BoltStore  *store,
   return res;
 }
 
+/* time stamps are updated on every connect and authorization
+ * and nobody is waiting for the result; they are written by a
+ * dedicated thread, so a slow disk cannot stall the hotplug
+ * handling. The queue is bounded, when full the caller waits.
+ * All other time stamp functions wait for the queue to drain
+ * first, so readers always see the latest values. */
+static void
+store_time_op_free (StoreTimeOp *op)
+{
+  g_free (op->uid);
+  g_free (op->timesel);
+  g_slice_free (StoreTimeOp, op);
+}
+
+static gboolean
+store_write_time (BoltStore  *store,
+                  const char *uid,
+                  const char *timesel,
+                  guint64     val,
+                  GError    **error)
+{
+  g_autoptr(GFile) gf = NULL;
+  g_autofree char *fn = NULL;
+  gboolean ok;
+
+  fn = g_strdup_printf ("%s.%s", uid, timesel);
+  gf = g_file_get_child (store->times, fn);
+
+  ok = bolt_fs_make_parent_dirs (gf, error);
+  if (!ok)
+    return FALSE;
+
+  ok = bolt_fs_touch (gf, val, val, error);
+
+  return ok;
+}
+
+static gpointer
+store_writer_thread (gpointer data)
+{
+  BoltStore *store = data;
+
+  g_mutex_lock (&store->wlock);
+
+  while (TRUE)
+    {
+      g_autoptr(GError) err = NULL;
+      StoreTimeOp *op;
+      gboolean ok;
+
+      while (g_queue_is_empty (&store->wqueue) && !store->wquit)
+        g_cond_wait (&store->wcond, &store->wlock);
+
+      op = g_queue_pop_head (&store->wqueue);
+
+      /* only quit once everything is written */
+      if (op == NULL)
+        break;
+
+      store->wbusy = TRUE;
+      g_mutex_unlock (&store->wlock);
+
+      ok = store_write_time (store, op->uid, op->timesel, op->val, &err);
+
+      if (!ok)
+        bolt_warn_err (err, LOG_DEV_UID (op->uid), LOG_TOPIC ("store"),
+                       "failed to update timestamp '%s'", op->timesel);
+
+      store_time_op_free (op);
+
+      g_mutex_lock (&store->wlock);
+      store->wbusy = FALSE;
+      g_cond_broadcast (&store->wcond);
+    }
+
+  g_mutex_unlock (&store->wlock);
+
+  return NULL;
+}
+
+static void
+store_writer_sync (BoltStore *store)
+{
+  /* the writer is only ever started and stopped
+   * from the thread that owns the store */
+  if (store->writer == NULL)
+    return;
+
+  g_mutex_lock (&store->wlock);
+
+  while (!g_queue_is_empty (&store->wqueue) || store->wbusy)
+    g_cond_wait (&store->wcond, &store->wlock);
+
+  g_mutex_unlock (&store->wlock);
+}
+
+static void
+store_writer_stop (BoltStore *store)
+{
+  if (store->writer != NULL)
+    {
+      g_mutex_lock (&store->wlock);
+      store->wquit = TRUE;
+      g_cond_broadcast (&store->wcond);
+      g_mutex_unlock (&store->wlock);
+
+      g_thread_join (store->writer);
+      store->writer = NULL;
+    }
+
+  g_queue_clear_full (&store->wqueue, (GDestroyNotify) store_time_op_free);
+  g_cond_clear (&store->wcond);
+  g_mutex_clear (&store->wlock);
+}
+
+void
+bolt_store_queue_times (BoltStore  *store,
+                        const char *uid,
+                        ...)
+{
+  g_autoptr(GError) err = NULL;
+  const char *ts;
+  va_list args;
+
+  /* like bolt_store_put_times, but for callers that do
+   * not care, and thus the device might not be stored */
+  if (store == NULL)
+    return;
+
+  g_return_if_fail (BOLT_IS_STORE (store));
+  g_return_if_fail (uid != NULL);
+
+  if (store->writer == NULL)
+    store->writer = g_thread_try_new ("bolt-store",
+                                      store_writer_thread,
+                                      store, &err);
+
+  if (store->writer == NULL)
+    bolt_warn_err (err, LOG_TOPIC ("store"),
+                   "could not start writer, writing synchronously");
+
+  va_start (args, uid);
+  while ((ts = va_arg (args, const char *)) != NULL)
+    {
+      guint64 val = va_arg (args, guint64);
+      StoreTimeOp *op;
+
+      if (val == 0)
+        continue;
+
+      if (store->writer == NULL)
+        {
+          g_autoptr(GError) error = NULL;
+          gboolean ok;
+
+          ok = store_write_time (store, uid, ts, val, &error);
+          if (!ok)
+            bolt_warn_err (error, LOG_DEV_UID (uid), LOG_TOPIC ("store"),
+                           "failed to update timestamp '%s'", ts);
+          continue;
+        }
+
+      op = g_slice_new (StoreTimeOp);
+      op->uid = g_strdup (uid);
+      op->timesel = g_strdup (ts);
+      op->val = val;
+
+      g_mutex_lock (&store->wlock);
+
+      while (g_queue_get_length (&store->wqueue) >= STORE_QUEUE_MAX)
+        g_cond_wait (&store->wcond, &store->wlock);
+
+      g_queue_push_tail (&store->wqueue, op);
+      g_cond_broadcast (&store->wcond);
+      g_mutex_unlock (&store->wlock);
+    }
+  va_end (args);
+}
+
 gboolean
 bolt_store_del_time (BoltStore  *store,
                      const char *uid,
@@ -899,6 +1124,8 @@ bolt_store_del_time (BoltStore  *store,
   g_return_val_if_fail (timesel != NULL, FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+  store_writer_sync (store);
+
   name = g_strdup_printf ("%s.%s", uid, timesel);
   pathfile = g_file_get_child (store->times, name);
   ok = g_file_delete (pathfile, NULL, error);
@@ -1089,3 +1316,15 @@ bolt_store_open_journal (BoltStore  *store,
 
   return journal;
 }
+
+BoltHistory *
+bolt_store_open_history (BoltStore  *store,
+                         const char *name,
+                         GError    **error)
+{
+  g_return_val_if_fail (store != NULL, NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return bolt_history_new (store->root, name, error);
+}
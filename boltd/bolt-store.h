@@ -26,6 +26,7 @@
 #include "bolt-domain.h"
 #include "bolt-enums.h"
 #include "bolt-key.h"
+#include "bolt-history.h"
 #include "bolt-journal.h"
 
 G_BEGIN_DECLS
@@ -43,6 +44,9 @@ gboolean          bolt_store_config_save (BoltStore *store,
                                           GKeyFile  *config,
                                           GError   **error);
 
+GKeyFile *        bolt_store_rules_load (BoltStore *store,
+                                         GError   **error);
+
 GStrv             bolt_store_list_uids (BoltStore  *store,
                                         const char *type,
                                         GError    **error);
@@ -88,6 +92,10 @@ gboolean          bolt_store_put_times (BoltStore  *store,
                                         GError    **error,
                                         ...) G_GNUC_NULL_TERMINATED;
 
+void              bolt_store_queue_times (BoltStore  *store,
+                                          const char *uid,
+                                          ...) G_GNUC_NULL_TERMINATED;
+
 gboolean          bolt_store_get_time (BoltStore  *store,
                                        const char *uid,
                                        const char *timesel,
@@ -130,4 +138,8 @@ BoltJournal *     bolt_store_open_journal (BoltStore  *store,
                                            const char *name,
                                            GError    **error);
 
+BoltHistory *     bolt_store_open_history (BoltStore  *store,
+                                           const char *name,
+                                           GError    **error);
+
 G_END_DECLS
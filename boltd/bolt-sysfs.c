@@ -28,8 +28,13 @@
 #include "bolt-str.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <libudev.h>
+#include <string.h>
+#include <linux/magic.h>
 #include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
 
 gint64
 bolt_sysfs_device_get_time (struct udev_device *udev,
@@ -310,3 +315,362 @@ bolt_sysfs_write_boot_acl (const char *device,
 
   return bolt_file_write_all (path, val, -1, error);
 }
+
+/* BoltSysfsDir
+ *
+ * libudev caches attribute values per udev_device, which is
+ * useless for values that change (authorized, boot_acl), and
+ * allocates for every value read. A BoltSysfsDir instead holds
+ * an O_PATH handle for the device directory, remembers its
+ * inode so that a different device showing up at the same path
+ * can be detected, and keeps the attribute files open once they
+ * have been used: sysfs re-generates the value for each read at
+ * offset 0, so a hot read is a single pread(2) into a caller
+ * supplied buffer. The attribute fds are opened lazily and
+ * published atomically, so a dir can be shared with the
+ * authorization thread. Other file systems, i.e. the mock
+ * sysfs of the tests, do not re-generate the values, so
+ * attribute files are not kept open there.
+ */
+struct _BoltSysfsDir
+{
+  gint     ref_count;
+
+  char    *path;
+  int      fd;
+  dev_t    st_dev;
+  ino_t    st_ino;
+  gboolean sysfs;   /* keep attribute files open */
+
+  gint     fds[BOLT_SYSFS_ATTR_LAST];
+};
+
+static const char *sysfs_attr_names[BOLT_SYSFS_ATTR_LAST] = {
+  [BOLT_SYSFS_AUTHORIZED] = "authorized",
+  [BOLT_SYSFS_KEY]        = "key",
+  [BOLT_SYSFS_BOOT]       = "boot",
+  [BOLT_SYSFS_UNIQUE_ID]  = "unique_id",
+  [BOLT_SYSFS_BOOT_ACL]   = "boot_acl",
+};
+
+/* sysfs values are at most a page */
+#define SYSFS_VALUE_MAX 4096
+
+/* 64 hex characters and the newline */
+#define SYSFS_KEY_MAX     72
+
+static int
+sysfs_dir_attr_fd (BoltSysfsDir *dir,
+                   BoltSysfsAttr attr,
+                   GError      **error)
+{
+  int fd;
+
+  fd = g_atomic_int_get (&dir->fds[attr]);
+
+  if (fd > -1)
+    return fd;
+
+  fd = bolt_openat (dir->fd, sysfs_attr_names[attr],
+                    O_RDONLY | O_CLOEXEC, 0, error);
+
+  if (fd < 0 || !dir->sysfs)
+    return fd;
+
+  /* somebody else might have been faster */
+  if (!g_atomic_int_compare_and_exchange (&dir->fds[attr], -1, fd))
+    {
+      close (fd);
+      fd = g_atomic_int_get (&dir->fds[attr]);
+    }
+
+  return fd;
+}
+
+BoltSysfsDir *
+bolt_sysfs_dir_open (const char *syspath,
+                     const char *uid,
+                     GError    **error)
+{
+  g_autoptr(BoltSysfsDir) dir = NULL;
+  struct statfs sfs;
+  struct stat st;
+  gboolean ok;
+
+  g_return_val_if_fail (syspath != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  dir = g_new0 (BoltSysfsDir, 1);
+  dir->ref_count = 1;
+  dir->path = g_strdup (syspath);
+
+  for (guint i = 0; i < BOLT_SYSFS_ATTR_LAST; i++)
+    dir->fds[i] = -1;
+
+  dir->fd = bolt_open (syspath, O_PATH | O_DIRECTORY | O_CLOEXEC, 0, error);
+
+  if (dir->fd < 0)
+    return NULL;
+
+  ok = bolt_fstat (dir->fd, &st, error);
+
+  if (!ok)
+    return NULL;
+
+  dir->st_dev = st.st_dev;
+  dir->st_ino = st.st_ino;
+
+  dir->sysfs = fstatfs (dir->fd, &sfs) == 0 && sfs.f_type == SYSFS_MAGIC;
+
+  if (uid != NULL && !bolt_sysfs_dir_verify_uid (dir, uid, error))
+    return NULL;
+
+  return g_steal_pointer (&dir);
+}
+
+BoltSysfsDir *
+bolt_sysfs_dir_ref (BoltSysfsDir *dir)
+{
+  g_return_val_if_fail (dir != NULL, NULL);
+
+  g_atomic_int_inc (&dir->ref_count);
+
+  return dir;
+}
+
+void
+bolt_sysfs_dir_unref (BoltSysfsDir *dir)
+{
+  g_return_if_fail (dir != NULL);
+
+  if (!g_atomic_int_dec_and_test (&dir->ref_count))
+    return;
+
+  for (guint i = 0; i < BOLT_SYSFS_ATTR_LAST; i++)
+    if (dir->fds[i] > -1)
+      close (dir->fds[i]);
+
+  if (dir->fd > -1)
+    close (dir->fd);
+
+  g_free (dir->path);
+  g_free (dir);
+}
+
+const char *
+bolt_sysfs_dir_get_path (BoltSysfsDir *dir)
+{
+  g_return_val_if_fail (dir != NULL, NULL);
+
+  return dir->path;
+}
+
+int
+bolt_sysfs_dir_get_fd (BoltSysfsDir *dir)
+{
+  g_return_val_if_fail (dir != NULL, -1);
+
+  return dir->fd;
+}
+
+gboolean
+bolt_sysfs_dir_validate (BoltSysfsDir *dir,
+                         GError      **error)
+{
+  struct stat st;
+  gboolean ok;
+
+  g_return_val_if_fail (dir != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  ok = bolt_fstatat (AT_FDCWD, dir->path, &st, 0, error);
+
+  if (!ok)
+    return FALSE;
+
+  if (st.st_dev != dir->st_dev || st.st_ino != dir->st_ino)
+    {
+      g_set_error (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                   "device at '%s' was replaced", dir->path);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+gssize
+bolt_sysfs_dir_read (BoltSysfsDir *dir,
+                     BoltSysfsAttr attr,
+                     char         *buf,
+                     gsize         len,
+                     GError      **error)
+{
+  ssize_t n;
+  int errsv;
+  int fd;
+
+  g_return_val_if_fail (dir != NULL, -1);
+  g_return_val_if_fail (attr < BOLT_SYSFS_ATTR_LAST, -1);
+  g_return_val_if_fail (buf != NULL && len > 0, -1);
+  g_return_val_if_fail (error == NULL || *error == NULL, -1);
+
+  fd = sysfs_dir_attr_fd (dir, attr, error);
+
+  if (fd < 0)
+    return -1;
+
+  do
+    n = pread (fd, buf, len - 1, 0);
+  while (n < 0 && errno == EINTR);
+
+  errsv = errno;
+
+  if (!dir->sysfs)
+    close (fd);
+
+  if (n < 0)
+    {
+      bolt_error_for_errno (error, errsv, "could not read '%s': %s",
+                            sysfs_attr_names[attr], g_strerror (errsv));
+      return -1;
+    }
+
+  /* like libudev, strip the trailing newline */
+  while (n > 0 && g_ascii_isspace (buf[n - 1]))
+    n--;
+
+  buf[n] = '\0';
+
+  return n;
+}
+
+gboolean
+bolt_sysfs_dir_read_int (BoltSysfsDir *dir,
+                         BoltSysfsAttr attr,
+                         gint         *val,
+                         GError      **error)
+{
+  char buf[32];
+  gssize n;
+  gboolean ok;
+
+  g_return_val_if_fail (val != NULL, FALSE);
+
+  n = bolt_sysfs_dir_read (dir, attr, buf, sizeof (buf), error);
+
+  if (n < 0)
+    return FALSE;
+
+  ok = bolt_str_parse_as_int (buf, val);
+
+  if (!ok)
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "could not parse '%s' of '%s' as integer: %s",
+                 buf, sysfs_attr_names[attr], g_strerror (errno));
+
+  return ok;
+}
+
+gboolean
+bolt_sysfs_dir_verify_uid (BoltSysfsDir *dir,
+                           const char   *uid,
+                           GError      **error)
+{
+  g_autoptr(GError) err = NULL;
+  char buf[64];
+  gssize n;
+
+  g_return_val_if_fail (uid != NULL, FALSE);
+
+  n = bolt_sysfs_dir_read (dir, BOLT_SYSFS_UNIQUE_ID,
+                           buf, sizeof (buf), &err);
+
+  if (n < 0)
+    {
+      g_set_error (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                   "unique id verification failed: %s",
+                   err->message);
+      return FALSE;
+    }
+
+  if (!bolt_streq (buf, uid))
+    {
+      g_set_error (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                   "unique id verification failed [%s != %s]",
+                   buf, uid);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+gboolean
+bolt_sysfs_dir_info (BoltSysfsDir *dir,
+                     BoltDevInfo  *info,
+                     GError      **error)
+{
+  char key[SYSFS_KEY_MAX];
+  gboolean ok;
+  gint val;
+
+  g_return_val_if_fail (dir != NULL, FALSE);
+  g_return_val_if_fail (info != NULL, FALSE);
+
+  info->keysize = -1;
+  info->ctim = -1;
+  info->full = FALSE;
+  info->parent = NULL;
+
+  ok = bolt_sysfs_dir_read_int (dir, BOLT_SYSFS_AUTHORIZED, &val, error);
+
+  if (!ok)
+    {
+      info->authorized = -1;
+      return FALSE;
+    }
+
+  info->authorized = val;
+  info->keysize = bolt_sysfs_dir_read (dir, BOLT_SYSFS_KEY,
+                                       key, sizeof (key), NULL);
+
+  ok = bolt_sysfs_dir_read_int (dir, BOLT_SYSFS_BOOT, &val, NULL);
+  info->boot = ok ? val : -1;
+
+  return TRUE;
+}
+
+gboolean
+bolt_sysfs_dir_read_boot_acl (BoltSysfsDir *dir,
+                              GStrv        *out,
+                              GError      **error)
+{
+  g_autoptr(GError) err = NULL;
+  g_auto(GStrv) acl = NULL;
+  char buf[SYSFS_VALUE_MAX];
+  gssize n;
+
+  g_return_val_if_fail (dir != NULL, FALSE);
+  g_return_val_if_fail (out != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  n = bolt_sysfs_dir_read (dir, BOLT_SYSFS_BOOT_ACL,
+                           buf, sizeof (buf), &err);
+
+  if (n < 0 && !bolt_err_notfound (err))
+    {
+      bolt_error_propagate (error, &err);
+      return FALSE;
+    }
+  else if (n > 0)
+    {
+      acl = g_strsplit (buf, ",", 1024);
+    }
+
+  /* if the attribute exists but is empty, return NULL */
+  if (!bolt_strv_isempty (acl))
+    *out = g_steal_pointer (&acl);
+  else
+    *out = NULL;
+
+  return TRUE;
+}
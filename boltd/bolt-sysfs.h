@@ -70,6 +70,59 @@ gboolean             bolt_sysfs_info_for_device (struct udev_device *udev,
                                                  BoltDevInfo        *info,
                                                  GError            **error);
 
+/* BoltSysfsDir - cached handle for a sysfs device directory */
+typedef struct _BoltSysfsDir BoltSysfsDir;
+
+typedef enum BoltSysfsAttr {
+  BOLT_SYSFS_AUTHORIZED,
+  BOLT_SYSFS_KEY,
+  BOLT_SYSFS_BOOT,
+  BOLT_SYSFS_UNIQUE_ID,
+  BOLT_SYSFS_BOOT_ACL,
+
+  BOLT_SYSFS_ATTR_LAST
+} BoltSysfsAttr;
+
+BoltSysfsDir *       bolt_sysfs_dir_open (const char *syspath,
+                                          const char *uid,
+                                          GError    **error);
+
+BoltSysfsDir *       bolt_sysfs_dir_ref (BoltSysfsDir *dir);
+
+void                 bolt_sysfs_dir_unref (BoltSysfsDir *dir);
+
+const char *         bolt_sysfs_dir_get_path (BoltSysfsDir *dir);
+
+int                  bolt_sysfs_dir_get_fd (BoltSysfsDir *dir);
+
+gboolean             bolt_sysfs_dir_validate (BoltSysfsDir *dir,
+                                              GError      **error);
+
+gssize               bolt_sysfs_dir_read (BoltSysfsDir *dir,
+                                          BoltSysfsAttr attr,
+                                          char         *buf,
+                                          gsize         len,
+                                          GError      **error);
+
+gboolean             bolt_sysfs_dir_read_int (BoltSysfsDir *dir,
+                                              BoltSysfsAttr attr,
+                                              gint         *val,
+                                              GError      **error);
+
+gboolean             bolt_sysfs_dir_verify_uid (BoltSysfsDir *dir,
+                                                const char   *uid,
+                                                GError      **error);
+
+gboolean             bolt_sysfs_dir_info (BoltSysfsDir *dir,
+                                          BoltDevInfo  *info,
+                                          GError      **error);
+
+gboolean             bolt_sysfs_dir_read_boot_acl (BoltSysfsDir *dir,
+                                                   GStrv        *out,
+                                                   GError      **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (BoltSysfsDir, bolt_sysfs_dir_unref);
+
 gboolean             bolt_sysfs_read_boot_acl (struct udev_device *udev,
                                                GStrv              *out,
                                                GError            **error);
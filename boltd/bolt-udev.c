@@ -29,6 +29,7 @@
 #include <string.h>
 
 #include <errno.h>
+#include <unistd.h>
 
 typedef struct udev_monitor udev_monitor;
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (udev_monitor, udev_monitor_unref);
@@ -68,9 +69,13 @@ static GParamSpec *props[PROP_LAST] = { NULL, };
 
 enum {
   SIGNAL_UEVENT,
+  SIGNAL_UEVENT_BATCH,
   SIGNAL_LAST,
 };
 
+/* maximum number of uevents received per wakeup */
+#define UEVENT_BATCH_MAX 64
+
 static guint signals[SIGNAL_LAST] = { 0, };
 
 
@@ -196,6 +201,20 @@ bolt_udev_class_init (BoltUdevClass *klass)
                   2,
                   G_TYPE_STRING,
                   G_TYPE_POINTER);
+
+  /* all uevents received in one go, as GPtrArray of
+   * struct udev_device; emitted before 'uevent' */
+  signals[SIGNAL_UEVENT_BATCH] =
+    g_signal_new ("uevent-batch",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL,
+                  NULL,
+                  g_cclosure_marshal_VOID__POINTER,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_POINTER);
 }
 
 static void
@@ -300,27 +319,47 @@ handle_uevent_udev (GIOChannel  *source,
                     GIOCondition condition,
                     gpointer     user_data)
 {
-  g_autoptr(udev_device) device = NULL;
+  g_autoptr(GPtrArray) batch = NULL;
   BoltUdev *udev;
-  const char *action;
-  const char *syspath;
 
   udev = BOLT_UDEV (user_data);
-  device = udev_monitor_receive_device (udev->monitor);
+  batch = g_ptr_array_new_with_free_func ((GDestroyNotify) udev_device_unref);
 
-  if (device == NULL)
-    return G_SOURCE_CONTINUE;
+  /* drain the socket, which is non-blocking, so a burst
+   * of events only costs one main loop iteration; the
+   * budget keeps other sources from being starved */
+  while (batch->len < UEVENT_BATCH_MAX)
+    {
+      g_autoptr(udev_device) device = NULL;
+
+      device = udev_monitor_receive_device (udev->monitor);
+
+      if (device == NULL)
+        break;
 
-  action = udev_device_get_action (device);
-  if (action == NULL)
+      if (udev_device_get_action (device) == NULL ||
+          udev_device_get_syspath (device) == NULL)
+        continue;
+
+      g_ptr_array_add (batch, g_steal_pointer (&device));
+    }
+
+  if (batch->len == 0)
     return G_SOURCE_CONTINUE;
 
-  syspath = udev_device_get_syspath (device);
-  if (syspath == NULL)
+  g_signal_emit (udev, signals[SIGNAL_UEVENT_BATCH], 0, batch);
+
+  if (!g_signal_has_handler_pending (udev, signals[SIGNAL_UEVENT], 0, FALSE))
     return G_SOURCE_CONTINUE;
 
-  g_signal_emit (udev, signals[SIGNAL_UEVENT], 0,
-                 action, device);
+  for (guint i = 0; i < batch->len; i++)
+    {
+      struct udev_device *device = g_ptr_array_index (batch, i);
+      const char *action = udev_device_get_action (device);
+
+      g_signal_emit (udev, signals[SIGNAL_UEVENT], 0,
+                     action, device);
+    }
 
   return G_SOURCE_CONTINUE;
 }
@@ -366,6 +405,22 @@ bolt_udev_new (const char         *name,
   return udev;
 }
 
+const char *
+bolt_udev_default_source (void)
+{
+  int r;
+
+  /* udevd creates its control socket once it is up; if it
+   * is not there, nobody would ever re-broadcast the kernel
+   * uevents on the udev netlink group, e.g. in an initramfs
+   * or a container, so listen to the kernel directly */
+  r = access ("/run/udev/control", F_OK);
+
+  if (r < 0)
+    return BOLT_UDEV_SOURCE_KERNEL;
+
+  return BOLT_UDEV_SOURCE_UDEV;
+}
 
 struct udev_enumerate *
 bolt_udev_new_enumerate (BoltUdev *udev,
@@ -29,6 +29,10 @@ struct udev;
 struct udev_device;
 struct udev_enumerate;
 
+/* uevent sources, i.e. the monitor names for bolt_udev_new () */
+#define BOLT_UDEV_SOURCE_UDEV   "udev"
+#define BOLT_UDEV_SOURCE_KERNEL "kernel"
+
 /* BoltUdev - small udev abstraction */
 #define BOLT_TYPE_UDEV bolt_udev_get_type ()
 G_DECLARE_FINAL_TYPE (BoltUdev, bolt_udev, BOLT, UDEV, GObject);
@@ -37,6 +41,8 @@ BoltUdev  *             bolt_udev_new (const char         *name,
                                        const char * const *filter,
                                        GError            **error);
 
+const char *           bolt_udev_default_source (void);
+
 struct udev_enumerate * bolt_udev_new_enumerate (BoltUdev *udev,
                                                  GError  **error);
 
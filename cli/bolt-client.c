@@ -38,6 +38,9 @@ static void         handle_dbus_domain_added (GObject    *self,
 static void         handle_dbus_domain_removed (GObject    *self,
                                                 GDBusProxy *bus_proxy,
                                                 GVariant   *params);
+static void         handle_dbus_resync (GObject    *self,
+                                        GDBusProxy *bus_proxy,
+                                        GVariant   *params);
 
 struct _BoltClient
 {
@@ -65,6 +68,7 @@ enum {
   SIGNAL_DEVICE_REMOVED,
   SIGNAL_DOMAIN_ADDED,
   SIGNAL_DOMAIN_REMOVED,
+  SIGNAL_RESYNC,
   SIGNAL_LAST
 };
 
@@ -96,6 +100,7 @@ bolt_client_get_dbus_signals (guint *n)
     {"DeviceRemoved", handle_dbus_device_removed},
     {"DomainAdded", handle_dbus_domain_added},
     {"DomainRemoved", handle_dbus_domain_removed},
+    {"Resync", handle_dbus_resync},
   };
 
   *n = G_N_ELEMENTS (dbus_signals);
@@ -203,6 +208,16 @@ bolt_client_class_init (BoltClientClass *klass)
                   NULL,
                   G_TYPE_NONE,
                   1, G_TYPE_STRING);
+
+  signals[SIGNAL_RESYNC] =
+    g_signal_new ("resync",
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,
+                  0);
 }
 
 
@@ -260,6 +275,14 @@ handle_dbus_domain_removed (GObject *self, GDBusProxy *bus_proxy, GVariant *para
   g_signal_emit (cli, signals[SIGNAL_DOMAIN_REMOVED], 0, opath);
 }
 
+static void
+handle_dbus_resync (GObject *self, GDBusProxy *bus_proxy, GVariant *params)
+{
+  BoltClient *cli = BOLT_CLIENT (self);
+
+  g_signal_emit (cli, signals[SIGNAL_RESYNC], 0);
+}
+
 
 /* public methods */
 
@@ -696,6 +719,43 @@ bolt_client_forget_device_finish (BoltClient   *client,
   return TRUE;
 }
 
+GVariant *
+bolt_client_get_history (BoltClient   *client,
+                         const char   *uid,
+                         guint64       since,
+                         guint64       until,
+                         guint         limit,
+                         GCancellable *cancel,
+                         GError      **error)
+{
+  g_autoptr(GVariant) val = NULL;
+  g_autoptr(GError) err = NULL;
+
+  g_return_val_if_fail (BOLT_IS_CLIENT (client), NULL);
+  g_return_val_if_fail (!cancel || G_IS_CANCELLABLE (cancel), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  val = g_dbus_proxy_call_sync (G_DBUS_PROXY (client),
+                                "GetHistory",
+                                g_variant_new ("(sttu)",
+                                               uid ? : "",
+                                               since,
+                                               until,
+                                               limit),
+                                G_DBUS_CALL_FLAGS_NONE,
+                                -1,
+                                cancel,
+                                &err);
+
+  if (val == NULL)
+    {
+      bolt_error_propagate_stripped (error, &err);
+      return NULL;
+    }
+
+  return g_variant_get_child_value (val, 0);
+}
+
 BoltPower *
 bolt_client_new_power_client (BoltClient   *client,
                               GCancellable *cancellable,
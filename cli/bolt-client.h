@@ -85,6 +85,14 @@ gboolean        bolt_client_forget_device_finish (BoltClient   *client,
                                                   GAsyncResult *res,
                                                   GError      **error);
 
+GVariant *      bolt_client_get_history (BoltClient   *client,
+                                         const char   *uid,
+                                         guint64       since,
+                                         guint64       until,
+                                         guint         limit,
+                                         GCancellable *cancellable,
+                                         GError      **error);
+
 BoltPower *     bolt_client_new_power_client (BoltClient   *client,
                                               GCancellable *cancellable,
                                               GError      **error);
@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "boltctl-cmds.h"
+#include "boltctl-uidfmt.h"
+
+#include "bolt-str.h"
+#include "bolt-time.h"
+
+#include <stdlib.h>
+
+int
+history (BoltClient *client, int argc, char **argv)
+{
+  g_autoptr(GOptionContext) optctx = NULL;
+  g_autoptr(GVariantIter) iter = NULL;
+  g_autoptr(GVariant) events = NULL;
+  g_autoptr(GError) error = NULL;
+  const char *uid = NULL;
+  const char *event;
+  const char *result;
+  guint64 since = 0;
+  guint64 ts;
+  guint32 duration;
+  int limit = 50;
+  int hours = 0;
+  GOptionEntry options[] = {
+    { "limit", 'n', 0, G_OPTION_ARG_INT, &limit, "Show at most N events (0 for all)", "N" },
+    { "hours", 0, 0, G_OPTION_ARG_INT, &hours, "Only show events of the last N hours", "N" },
+    { NULL }
+  };
+
+  optctx = g_option_context_new ("[DEVICE] - Show the history of device events");
+  g_option_context_add_main_entries (optctx, options, NULL);
+
+  if (!g_option_context_parse (optctx, &argc, &argv, &error))
+    return usage_error (error);
+
+  if (argc > 2)
+    return usage_error_too_many_args ();
+  else if (argc == 2)
+    uid = argv[1];
+
+  if (limit < 0 || hours < 0)
+    {
+      g_set_error_literal (&error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                           "negative values are not allowed");
+      return usage_error (error);
+    }
+
+  if (hours > 0)
+    {
+      guint64 now = (guint64) g_get_real_time ();
+      guint64 span = (guint64) hours * G_USEC_PER_SEC * 60 * 60;
+
+      since = now > span ? now - span : 0;
+    }
+
+  events = bolt_client_get_history (client, uid, since, 0,
+                                    (guint) limit, NULL, &error);
+
+  if (events == NULL)
+    {
+      g_printerr ("Failed to get history: %s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  iter = g_variant_iter_new (events);
+  while (g_variant_iter_next (iter, "(t&s&s&su)",
+                              &ts, &uid, &event, &result, &duration))
+    {
+      g_autofree char *when = NULL;
+
+      when = bolt_epoch_format (ts / G_USEC_PER_SEC, "%F %T");
+
+      g_print ("%s  %-10s %s", when, event, format_uid (uid));
+
+      if (*result != '\0')
+        g_print (" %s (%u ms)", result, duration);
+
+      g_print ("\n");
+    }
+
+  return EXIT_SUCCESS;
+}
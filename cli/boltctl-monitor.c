@@ -190,6 +190,13 @@ handle_probing_changed (BoltClient *client,
     g_print ("Probing done\n");
 }
 
+static void
+handle_resync (BoltClient *client,
+               gpointer    user_data)
+{
+  g_print ("Events were lost, run 'boltctl list' to resync\n");
+}
+
 int
 monitor (BoltClient *client, int argc, char **argv)
 {
@@ -269,6 +276,9 @@ monitor (BoltClient *client, int argc, char **argv)
   g_signal_connect (client, "notify::probing",
                     G_CALLBACK (handle_probing_changed), NULL);
 
+  g_signal_connect (client, "resync",
+                    G_CALLBACK (handle_resync), NULL);
+
   main_loop = g_main_loop_new (NULL, FALSE);
   g_main_loop_run (main_loop);
 
@@ -285,6 +285,7 @@ static SubCommand subcommands[] = {
   {"domains",      list_domains,  "List the active thunderbolt domains"},
   {"enroll",       enroll,        "Authorize and store a device in the database"},
   {"forget",       forget,        "Remove a stored device from the database"},
+  {"history",      history,       "Show the history of device events"},
   {"info",         info,          "Show information about a device"},
   {"list",         list_devices,  "List connected and stored devices"},
   {"monitor",      monitor,       "Listen and print changes"},
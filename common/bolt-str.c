@@ -320,3 +320,111 @@ bolt_comparefn_strcmp (gconstpointer a,
 
   return g_strcmp0 (*astrv, *bstrv);
 }
+
+/* refcounted string pool: equal strings share one buffer that
+ * is freed once the last reference is gone. The pool is used
+ * from the probing threads, hence the lock. */
+typedef struct PoolStr
+{
+  guint ref;
+  char  str[];
+} PoolStr;
+
+#define POOL_STR(s) ((PoolStr *) ((s) - G_STRUCT_OFFSET (PoolStr, str)))
+
+/* per distinct string: the refcount header and the hash table
+ * slot, i.e. key, value and the cached hash */
+#define POOL_ENTRY_OVERHEAD \
+  (sizeof (PoolStr) + 2 * sizeof (gpointer) + sizeof (guint))
+
+static GMutex      str_pool_lock;
+static GHashTable *str_pool = NULL; /* str -> PoolStr */
+static guint       str_pool_refs = 0;
+static gsize       str_pool_bytes = 0;  /* string data */
+static gsize       str_pool_shared = 0; /* copies not made */
+
+const char *
+bolt_str_pool_ref (const char *str)
+{
+  PoolStr *ps;
+  gsize len;
+
+  if (str == NULL)
+    return NULL;
+
+  len = strlen (str) + 1;
+
+  g_mutex_lock (&str_pool_lock);
+
+  if (G_UNLIKELY (str_pool == NULL))
+    str_pool = g_hash_table_new (g_str_hash, g_str_equal);
+
+  ps = g_hash_table_lookup (str_pool, str);
+
+  if (ps != NULL)
+    {
+      ps->ref++;
+      str_pool_shared += len;
+    }
+  else
+    {
+      ps = g_malloc (sizeof (PoolStr) + len);
+      ps->ref = 1;
+      memcpy (ps->str, str, len);
+
+      g_hash_table_insert (str_pool, ps->str, ps);
+      str_pool_bytes += len;
+    }
+
+  str_pool_refs++;
+
+  g_mutex_unlock (&str_pool_lock);
+
+  return ps->str;
+}
+
+void
+bolt_str_pool_unref (const char *str)
+{
+  PoolStr *ps;
+  gsize len;
+
+  if (str == NULL)
+    return;
+
+  ps = POOL_STR (str);
+  len = strlen (str) + 1;
+
+  g_mutex_lock (&str_pool_lock);
+
+  str_pool_refs--;
+
+  if (--ps->ref > 0)
+    {
+      str_pool_shared -= len;
+    }
+  else
+    {
+      g_hash_table_remove (str_pool, ps->str);
+      str_pool_bytes -= len;
+      g_free (ps);
+    }
+
+  g_mutex_unlock (&str_pool_lock);
+}
+
+void
+bolt_str_pool_stats (BoltStrPoolStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  g_mutex_lock (&str_pool_lock);
+
+  stats->count = str_pool ? g_hash_table_size (str_pool) : 0;
+  stats->refs = str_pool_refs;
+  stats->bytes = str_pool_bytes + stats->count * POOL_ENTRY_OVERHEAD;
+  stats->saved = (gssize) str_pool_shared -
+                 (gssize) (stats->count * POOL_ENTRY_OVERHEAD);
+
+  g_mutex_unlock (&str_pool_lock);
+}
@@ -88,4 +88,39 @@ gboolean bolt_set_strdup_printf (char      **target,
 gint     bolt_comparefn_strcmp (gconstpointer a,
                                 gconstpointer b);
 
+/* refcounted string pool */
+typedef struct BoltStrPoolStats
+{
+  guint count;  /* number of distinct strings */
+  guint refs;   /* number of references to them */
+  gsize  bytes; /* memory used by the pool, including overhead */
+  gssize saved; /* memory saved compared to plain copies, net of
+                 * the overhead, i.e. negative if nothing is shared */
+} BoltStrPoolStats;
+
+const char * bolt_str_pool_ref (const char *str);
+void         bolt_str_pool_unref (const char *str);
+void         bolt_str_pool_stats (BoltStrPoolStats *stats);
+
+/* replacing pooled string pointers */
+static inline gboolean
+bolt_set_str_pooled (const char **target, const char *str)
+{
+  const char *ptr;
+
+  g_return_val_if_fail (target != NULL, FALSE);
+
+  ptr = *target;
+
+  if (ptr != NULL && str != NULL && strcmp (ptr, str) == 0)
+    return FALSE;
+  else if (ptr == str)
+    return FALSE;
+
+  *target = bolt_str_pool_ref (str);
+  bolt_str_pool_unref (ptr);
+
+  return TRUE;
+}
+
 G_END_DECLS
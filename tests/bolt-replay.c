@@ -0,0 +1,1044 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "bolt-enums.h"
+#include "bolt-error.h"
+#include "bolt-manager.h"
+#include "bolt-str.h"
+#include "bolt-udev.h"
+
+#include "bolt-test.h"
+#include "mock-sysfs.h"
+
+#include <glib-unix.h>
+#include <libudev.h>
+#include <umockdev.h>
+
+#include <locale.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Recordings are key files: a [recording] group with the
+ * meta data and one [event N] group per uevent, in the order
+ * they were received. 'time' is in micro-seconds, relative
+ * to the start of the recording. Devices that were present
+ * when the recording was started are included as 'add'
+ * events at time 0, marked with 'coldplug'. The content of
+ * the 'key' attribute is never recorded, only if it exists.
+ */
+#define RECORD_GROUP   "recording"
+#define RECORD_VERSION 1
+
+static const char *record_attrs[] = {
+  "vendor",
+  "vendor_name",
+  "device",
+  "device_name",
+  "unique_id",
+  "authorized",
+  "boot",
+  "security",
+  "boot_acl",
+  NULL
+};
+
+/* attributes that are written to the mock sysfs on 'change' */
+static const char *change_attrs[] = {
+  "authorized",
+  "boot",
+  "boot_acl",
+  NULL
+};
+
+/* a replay without any progress for this long is stuck */
+#define REPLAY_STALL_TIMEOUT 5 /* seconds */
+
+static void
+key_file_set_maybe (GKeyFile   *kf,
+                    const char *group,
+                    const char *key,
+                    const char *val)
+{
+  if (val == NULL)
+    return;
+
+  g_key_file_set_string (kf, group, key, val);
+}
+
+/* record */
+typedef struct Recorder
+{
+  GKeyFile  *kf;
+  GMainLoop *loop;
+  gint64     start;
+  guint      count;
+} Recorder;
+
+static void
+recorder_add (Recorder           *rec,
+              struct udev_device *dev,
+              const char         *action,
+              gint64              now,
+              gboolean            coldplug)
+{
+  g_autofree char *group = NULL;
+  g_autofree char *key = NULL;
+  struct udev_device *parent;
+  const char *syspath;
+
+  syspath = udev_device_get_syspath (dev);
+  group = g_strdup_printf ("event %u", rec->count++);
+
+  g_key_file_set_int64 (rec->kf, group, "time", now - rec->start);
+  g_key_file_set_string (rec->kf, group, "action", action);
+  g_key_file_set_string (rec->kf, group, "syspath", syspath);
+
+  key_file_set_maybe (rec->kf, group, "subsystem",
+                      udev_device_get_subsystem (dev));
+  key_file_set_maybe (rec->kf, group, "devtype",
+                      udev_device_get_devtype (dev));
+
+  if (coldplug)
+    g_key_file_set_boolean (rec->kf, group, "coldplug", TRUE);
+
+  /* the device is already gone from sysfs */
+  if (bolt_streq (action, "remove"))
+    return;
+
+  parent = udev_device_get_parent (dev);
+  if (parent != NULL)
+    key_file_set_maybe (rec->kf, group, "parent",
+                        udev_device_get_syspath (parent));
+
+  for (guint i = 0; record_attrs[i] != NULL; i++)
+    {
+      const char *attr = record_attrs[i];
+      const char *val = udev_device_get_sysattr_value (dev, attr);
+
+      key_file_set_maybe (rec->kf, group, attr, val);
+    }
+
+  key = g_build_filename (syspath, "key", NULL);
+  if (g_file_test (key, G_FILE_TEST_EXISTS))
+    g_key_file_set_boolean (rec->kf, group, "key", TRUE);
+}
+
+static gint
+compare_syspath_length (gconstpointer a,
+                        gconstpointer b)
+{
+  const char *pa = *((const char **) a);
+  const char *pb = *((const char **) b);
+
+  return (gint) strlen (pa) - (gint) strlen (pb);
+}
+
+static gboolean
+recorder_coldplug (Recorder *rec,
+                   BoltUdev *udev,
+                   GError  **error)
+{
+  g_autoptr(GPtrArray) paths = NULL;
+  struct udev_enumerate *e;
+  struct udev_list_entry *l, *devices;
+  int r;
+
+  e = bolt_udev_new_enumerate (udev, error);
+  if (e == NULL)
+    return FALSE;
+
+  udev_enumerate_add_match_subsystem (e, "thunderbolt");
+  r = udev_enumerate_scan_devices (e);
+
+  if (r < 0)
+    {
+      udev_enumerate_unref (e);
+      return bolt_error_for_errno (error, -r, "failed to scan udev: %s",
+                                   g_strerror (-r));
+    }
+
+  paths = g_ptr_array_new_with_free_func (g_free);
+  devices = udev_enumerate_get_list_entry (e);
+
+  udev_list_entry_foreach (l, devices)
+    g_ptr_array_add (paths, g_strdup (udev_list_entry_get_name (l)));
+
+  udev_enumerate_unref (e);
+
+  /* parents have shorter paths, so they are added first */
+  g_ptr_array_sort (paths, compare_syspath_length);
+
+  for (guint i = 0; i < paths->len; i++)
+    {
+      const char *syspath = g_ptr_array_index (paths, i);
+      struct udev_device *dev;
+
+      dev = bolt_udev_device_new_from_syspath (udev, syspath, NULL);
+      if (dev == NULL)
+        continue;
+
+      recorder_add (rec, dev, "add", rec->start, TRUE);
+      udev_device_unref (dev);
+    }
+
+  return TRUE;
+}
+
+static void
+recorder_uevent (BoltUdev           *udev,
+                 const char         *action,
+                 struct udev_device *device,
+                 gpointer            user_data)
+{
+  Recorder *rec = user_data;
+  gint64 now = g_get_monotonic_time ();
+
+  recorder_add (rec, device, action, now, FALSE);
+  g_print ("%8.3f %-7s %s\n",
+           (double) (now - rec->start) / G_USEC_PER_SEC,
+           action, udev_device_get_syspath (device));
+}
+
+static gboolean
+recorder_stop (gpointer user_data)
+{
+  Recorder *rec = user_data;
+
+  g_main_loop_quit (rec->loop);
+  return G_SOURCE_REMOVE;
+}
+
+static int
+record (int argc, char **argv)
+{
+  g_autoptr(GOptionContext) optctx = NULL;
+  g_autoptr(GError) err = NULL;
+  g_autoptr(BoltUdev) udev = NULL;
+  g_autofree char *source = NULL;
+  const char *filter[] = {"thunderbolt", "pci", "wmi", NULL};
+  Recorder rec = { NULL, };
+  int duration = 0;
+  gboolean ok;
+  GOptionEntry options[] = {
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Stop after SECONDS", "SECONDS" },
+    { "source", 0, 0, G_OPTION_ARG_STRING, &source, "uevent source (udev, kernel)", "SOURCE" },
+    { NULL }
+  };
+
+  optctx = g_option_context_new ("FILE - Record uevents");
+  g_option_context_add_main_entries (optctx, options, NULL);
+
+  if (!g_option_context_parse (optctx, &argc, &argv, &err))
+    {
+      g_printerr ("%s\n", err->message);
+      return EXIT_FAILURE;
+    }
+
+  if (argc != 2)
+    {
+      g_printerr ("need exactly one file to record to\n");
+      return EXIT_FAILURE;
+    }
+
+  udev = bolt_udev_new (source ? : BOLT_UDEV_SOURCE_UDEV, filter, &err);
+  if (udev == NULL)
+    {
+      g_printerr ("could not create udev monitor: %s\n", err->message);
+      return EXIT_FAILURE;
+    }
+
+  rec.kf = g_key_file_new ();
+  rec.loop = g_main_loop_new (NULL, FALSE);
+  rec.start = g_get_monotonic_time ();
+
+  g_key_file_set_integer (rec.kf, RECORD_GROUP, "version", RECORD_VERSION);
+  g_key_file_set_string (rec.kf, RECORD_GROUP, "source",
+                         source ? : BOLT_UDEV_SOURCE_UDEV);
+  g_key_file_set_int64 (rec.kf, RECORD_GROUP, "started", g_get_real_time ());
+
+  ok = recorder_coldplug (&rec, udev, &err);
+  if (!ok)
+    {
+      g_printerr ("could not enumerate devices: %s\n", err->message);
+      g_clear_error (&err);
+    }
+
+  g_signal_connect (udev, "uevent", G_CALLBACK (recorder_uevent), &rec);
+
+  g_unix_signal_add (SIGINT, recorder_stop, &rec);
+  g_unix_signal_add (SIGTERM, recorder_stop, &rec);
+
+  if (duration > 0)
+    g_timeout_add_seconds ((guint) duration, recorder_stop, &rec);
+
+  g_print ("recording, %u devices present; stop with ^C\n", rec.count);
+  g_main_loop_run (rec.loop);
+
+  g_key_file_set_uint64 (rec.kf, RECORD_GROUP, "events", rec.count);
+  ok = g_key_file_save_to_file (rec.kf, argv[1], &err);
+
+  g_main_loop_unref (rec.loop);
+  g_key_file_unref (rec.kf);
+
+  if (!ok)
+    {
+      g_printerr ("could not save recording: %s\n", err->message);
+      return EXIT_FAILURE;
+    }
+
+  g_print ("%u events recorded to %s\n", rec.count, argv[1]);
+  return EXIT_SUCCESS;
+}
+
+/* replay */
+typedef struct Event
+{
+  char  *group;
+  char  *action;
+  gint64 time;        /* as recorded */
+
+  char  *path;        /* mock sysfs path, once injected */
+  gint64 injected;
+  gint64 delivered;
+  gint64 settled;
+} Event;
+
+static void
+event_free (gpointer data)
+{
+  Event *ev = data;
+
+  g_free (ev->group);
+  g_free (ev->action);
+  g_free (ev->path);
+  g_slice_free (Event, ev);
+}
+
+typedef struct Replay
+{
+  GKeyFile    *kf;
+  gboolean     fast;
+
+  MockSysfs   *sysfs;
+  UMockdevTestbed *bed;
+  BoltManager *mgr;
+  BoltUdev    *udev;
+  GMainLoop   *loop;
+
+  GHashTable  *domains;   /* recorded syspath -> mock domain id */
+  GHashTable  *devices;   /* recorded syspath -> mock device id */
+
+  GPtrArray   *events;    /* Event, in recorded order */
+  guint        next;      /* index of the next event to inject */
+  GQueue       inflight;  /* injected, not yet delivered */
+  GPtrArray   *delivered; /* delivered, not yet settled */
+
+  gint64       start;
+  gint64       end;
+  guint        timer;     /* next injection, timed mode */
+  guint        settle;    /* idle or retry source */
+  guint        watchdog;
+  guint        progress;  /* deliveries, for the watchdog */
+  guint        seen;      /* progress at the last watchdog check */
+
+  guint        ignored;   /* not thunderbolt */
+  guint        skipped;   /* could not be injected */
+  guint        lost;      /* injected, never delivered */
+} Replay;
+
+static void     replay_schedule (Replay *r);
+
+static gboolean
+replay_load (Replay     *r,
+             const char *file,
+             GError    **error)
+{
+  g_auto(GStrv) groups = NULL;
+  gboolean ok;
+  guint version;
+
+  ok = g_key_file_load_from_file (r->kf, file, G_KEY_FILE_NONE, error);
+  if (!ok)
+    return FALSE;
+
+  version = (guint) g_key_file_get_integer (r->kf, RECORD_GROUP,
+                                            "version", NULL);
+  if (version != RECORD_VERSION)
+    {
+      g_set_error (error, BOLT_ERROR, BOLT_ERROR_FAILED,
+                   "unsupported recording version: %u", version);
+      return FALSE;
+    }
+
+  groups = g_key_file_get_groups (r->kf, NULL);
+
+  for (guint i = 0; groups[i] != NULL; i++)
+    {
+      g_autofree char *subsystem = NULL;
+      Event *ev;
+
+      if (!g_str_has_prefix (groups[i], "event "))
+        continue;
+
+      /* pci and wmi devices can not be modeled by the mock
+       * sysfs, since they are not thunderbolt devices */
+      subsystem = g_key_file_get_string (r->kf, groups[i],
+                                         "subsystem", NULL);
+      if (!bolt_streq (subsystem, "thunderbolt"))
+        {
+          r->ignored++;
+          continue;
+        }
+
+      ev = g_slice_new0 (Event);
+      ev->group = g_strdup (groups[i]);
+      ev->action = g_key_file_get_string (r->kf, groups[i], "action", NULL);
+      ev->time = g_key_file_get_int64 (r->kf, groups[i], "time", NULL);
+
+      if (ev->action == NULL)
+        {
+          event_free (ev);
+          r->skipped++;
+          continue;
+        }
+
+      g_ptr_array_add (r->events, ev);
+    }
+
+  return TRUE;
+}
+
+static char *
+replay_add_domain (Replay     *r,
+                   const char *group)
+{
+  g_autofree char *security = NULL;
+  g_autofree char *acl = NULL;
+  g_auto(GStrv) bootacl = NULL;
+  BoltSecurity level;
+  const char *id;
+
+  security = g_key_file_get_string (r->kf, group, "security", NULL);
+  acl = g_key_file_get_string (r->kf, group, "boot_acl", NULL);
+
+  level = bolt_enum_from_string (BOLT_TYPE_SECURITY, security, NULL);
+  if (level == BOLT_SECURITY_UNKNOWN)
+    level = BOLT_SECURITY_NONE;
+
+  if (acl != NULL)
+    bootacl = g_strsplit (acl, ",", 1024);
+
+  id = mock_sysfs_domain_add (r->sysfs, level, bootacl);
+  if (id == NULL)
+    return NULL;
+
+  return g_strdup (id);
+}
+
+static char *
+replay_add_device (Replay     *r,
+                   const char *group)
+{
+  g_autofree char *parent = NULL;
+  g_autofree char *vendor = NULL;
+  g_autofree char *vendor_name = NULL;
+  g_autofree char *device = NULL;
+  g_autofree char *device_name = NULL;
+  g_autofree char *unique_id = NULL;
+  g_autofree char *authorized = NULL;
+  g_autofree char *boot = NULL;
+  const char *dom;
+  const char *pid;
+  const char *id;
+  gboolean key;
+  MockDevId devid;
+
+  parent = g_key_file_get_string (r->kf, group, "parent", NULL);
+  vendor = g_key_file_get_string (r->kf, group, "vendor", NULL);
+  vendor_name = g_key_file_get_string (r->kf, group, "vendor_name", NULL);
+  device = g_key_file_get_string (r->kf, group, "device", NULL);
+  device_name = g_key_file_get_string (r->kf, group, "device_name", NULL);
+  unique_id = g_key_file_get_string (r->kf, group, "unique_id", NULL);
+  authorized = g_key_file_get_string (r->kf, group, "authorized", NULL);
+  boot = g_key_file_get_string (r->kf, group, "boot", NULL);
+  key = g_key_file_get_boolean (r->kf, group, "key", NULL);
+
+  if (parent == NULL || unique_id == NULL)
+    return NULL;
+
+  devid.vendor_id = vendor ? (gint) g_ascii_strtoll (vendor, NULL, 0) : 0;
+  devid.vendor_name = vendor_name ? : "";
+  devid.device_id = device ? (gint) g_ascii_strtoll (device, NULL, 0) : 0;
+  devid.device_name = device_name ? : "";
+  devid.unique_id = unique_id;
+
+  dom = g_hash_table_lookup (r->domains, parent);
+  pid = g_hash_table_lookup (r->devices, parent);
+
+  if (dom != NULL)
+    id = mock_sysfs_host_add (r->sysfs, dom, &devid);
+  else if (pid != NULL)
+    id = mock_sysfs_device_add (r->sysfs, pid, &devid,
+                                authorized ? (guint) atoi (authorized) : 0,
+                                key ? "" : NULL,
+                                boot ? atoi (boot) : 0);
+  else
+    id = NULL;
+
+  if (id == NULL)
+    return NULL;
+
+  return g_strdup (id);
+}
+
+static gboolean
+replay_change (Replay     *r,
+               const char *group,
+               const char *path)
+{
+  for (guint i = 0; change_attrs[i] != NULL; i++)
+    {
+      const char *attr = change_attrs[i];
+      g_autofree char *val = NULL;
+
+      val = g_key_file_get_string (r->kf, group, attr, NULL);
+      if (val == NULL)
+        continue;
+
+      umockdev_testbed_set_attribute (r->bed, path, attr, val);
+    }
+
+  umockdev_testbed_uevent (r->bed, path, "change");
+  return TRUE;
+}
+
+static gboolean
+replay_inject (Replay *r,
+               Event  *ev)
+{
+  g_autofree char *syspath = NULL;
+  g_autofree char *devtype = NULL;
+  const char *path = NULL;
+  const char *id;
+  gboolean domain;
+  gboolean ok = FALSE;
+
+  syspath = g_key_file_get_string (r->kf, ev->group, "syspath", NULL);
+  devtype = g_key_file_get_string (r->kf, ev->group, "devtype", NULL);
+
+  if (syspath == NULL)
+    return FALSE;
+
+  domain = bolt_streq (devtype, "thunderbolt_domain");
+
+  if (domain)
+    id = g_hash_table_lookup (r->domains, syspath);
+  else
+    id = g_hash_table_lookup (r->devices, syspath);
+
+  if (id != NULL && domain)
+    path = mock_sysfs_domain_get_syspath (r->sysfs, id);
+  else if (id != NULL)
+    path = mock_sysfs_device_get_syspath (r->sysfs, id);
+
+  /* the mock sysfs emits the uevent synchronously */
+  ev->injected = g_get_monotonic_time ();
+
+  if (bolt_streq (ev->action, "add") && id == NULL)
+    {
+      char *added;
+
+      if (domain)
+        added = replay_add_domain (r, ev->group);
+      else
+        added = replay_add_device (r, ev->group);
+
+      if (added == NULL)
+        return FALSE;
+
+      if (domain)
+        {
+          g_hash_table_insert (r->domains, g_strdup (syspath), added);
+          path = mock_sysfs_domain_get_syspath (r->sysfs, added);
+        }
+      else
+        {
+          g_hash_table_insert (r->devices, g_strdup (syspath), added);
+          path = mock_sysfs_device_get_syspath (r->sysfs, added);
+        }
+
+      ev->path = g_strdup (path);
+      ok = TRUE;
+    }
+  else if (bolt_streq (ev->action, "change") && path != NULL)
+    {
+      ev->path = g_strdup (path);
+      ok = replay_change (r, ev->group, path);
+    }
+  else if (bolt_streq (ev->action, "remove") && path != NULL)
+    {
+      /* the path is owned by the mock sysfs */
+      ev->path = g_strdup (path);
+
+      if (domain)
+        ok = mock_sysfs_domain_remove (r->sysfs, id);
+      else
+        ok = mock_sysfs_device_remove (r->sysfs, id);
+
+      if (domain)
+        g_hash_table_remove (r->domains, syspath);
+      else
+        g_hash_table_remove (r->devices, syspath);
+    }
+
+  return ok;
+}
+
+static void
+replay_finish (Replay *r)
+{
+  r->end = g_get_monotonic_time ();
+  g_main_loop_quit (r->loop);
+}
+
+static gboolean
+replay_is_done (Replay *r)
+{
+  return r->next >= r->events->len &&
+         g_queue_is_empty (&r->inflight) &&
+         r->delivered->len == 0;
+}
+
+static gboolean replay_settle_idle (gpointer user_data);
+
+static gboolean
+replay_settle_retry (gpointer user_data)
+{
+  Replay *r = user_data;
+
+  r->settle = g_idle_add_full (G_PRIORITY_LOW, replay_settle_idle, r, NULL);
+  return G_SOURCE_REMOVE;
+}
+
+/* runs once nothing else is ready to be dispatched */
+static gboolean
+replay_settle_idle (gpointer user_data)
+{
+  Replay *r = user_data;
+  gint64 now;
+
+  /* batched events and authorizations finish later */
+  if (bolt_manager_is_busy (r->mgr))
+    {
+      r->settle = g_timeout_add (1, replay_settle_retry, r);
+      return G_SOURCE_REMOVE;
+    }
+
+  r->settle = 0;
+  now = g_get_monotonic_time ();
+
+  for (guint i = 0; i < r->delivered->len; i++)
+    {
+      Event *ev = g_ptr_array_index (r->delivered, i);
+      ev->settled = now;
+    }
+
+  g_ptr_array_set_size (r->delivered, 0);
+
+  if (replay_is_done (r))
+    replay_finish (r);
+  else if (r->fast && g_queue_is_empty (&r->inflight))
+    replay_schedule (r);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+replay_uevent (BoltUdev           *udev,
+               const char         *action,
+               struct udev_device *device,
+               gpointer            user_data)
+{
+  Replay *r = user_data;
+  const char *syspath;
+  GList *l;
+
+  syspath = udev_device_get_syspath (device);
+
+  /* the mock sysfs might emit events that were not
+   * injected directly, e.g. for removed children */
+  for (l = r->inflight.head; l != NULL; l = l->next)
+    {
+      Event *ev = l->data;
+
+      if (bolt_streq (ev->path, syspath) &&
+          bolt_streq (ev->action, action))
+        break;
+    }
+
+  if (l == NULL)
+    return;
+
+  ((Event *) l->data)->delivered = g_get_monotonic_time ();
+  g_ptr_array_add (r->delivered, l->data);
+  g_queue_delete_link (&r->inflight, l);
+  r->progress++;
+
+  if (r->settle == 0)
+    r->settle = g_idle_add_full (G_PRIORITY_LOW, replay_settle_idle, r, NULL);
+}
+
+static gboolean
+replay_timer (gpointer user_data)
+{
+  Replay *r = user_data;
+
+  r->timer = 0;
+  replay_schedule (r);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* inject the next event(s): in timed mode all that are due,
+ * in fast mode one, since it waits for them to settle */
+static void
+replay_schedule (Replay *r)
+{
+  while (r->next < r->events->len)
+    {
+      Event *ev = g_ptr_array_index (r->events, r->next);
+      gint64 now = g_get_monotonic_time ();
+      gint64 due = r->start + ev->time;
+
+      if (!r->fast && due > now)
+        {
+          guint ms = (guint) ((due - now + 999) / 1000);
+          r->timer = g_timeout_add (ms, replay_timer, r);
+          return;
+        }
+
+      r->next++;
+
+      if (!replay_inject (r, ev))
+        {
+          r->skipped++;
+          continue;
+        }
+
+      g_queue_push_tail (&r->inflight, ev);
+
+      if (r->fast)
+        return;
+    }
+
+  if (replay_is_done (r))
+    replay_finish (r);
+}
+
+static gboolean
+replay_watchdog (gpointer user_data)
+{
+  Replay *r = user_data;
+  guint n;
+
+  if (r->progress != r->seen || g_queue_is_empty (&r->inflight))
+    {
+      r->seen = r->progress;
+      return G_SOURCE_CONTINUE;
+    }
+
+  n = g_queue_get_length (&r->inflight);
+  g_printerr ("no progress for %d seconds, %u events lost\n",
+              REPLAY_STALL_TIMEOUT, n);
+
+  r->lost += n;
+  g_queue_clear (&r->inflight);
+
+  if (replay_is_done (r))
+    replay_finish (r);
+  else if (r->fast && r->delivered->len == 0)
+    replay_schedule (r);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gint
+compare_int64 (gconstpointer a,
+               gconstpointer b)
+{
+  gint64 ia = *((const gint64 *) a);
+  gint64 ib = *((const gint64 *) b);
+
+  return ia < ib ? -1 : (ia > ib ? 1 : 0);
+}
+
+static void
+replay_report_stage (const char *name,
+                     GArray     *values)
+{
+  gint64 sum = 0;
+  gint64 *v;
+  guint n = values->len;
+
+  if (n == 0)
+    {
+      g_print ("%-12s %10s\n", name, "-");
+      return;
+    }
+
+  g_array_sort (values, compare_int64);
+  v = (gint64 *) values->data;
+
+  for (guint i = 0; i < n; i++)
+    sum += v[i];
+
+#define MS(us) ((double) (us) / 1000.0)
+  g_print ("%-12s %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+           name,
+           MS (v[0]),
+           MS (sum / n),
+           MS (v[n / 2]),
+           MS (v[MIN (n - 1, (n * 95) / 100)]),
+           MS (v[n - 1]));
+#undef MS
+}
+
+static void
+replay_report (Replay *r)
+{
+  g_autoptr(GArray) delivery = NULL;
+  g_autoptr(GArray) processing = NULL;
+  g_autoptr(GArray) total = NULL;
+  gint64 first = 0;
+  gint64 wall;
+  guint count = 0;
+
+  delivery = g_array_new (FALSE, FALSE, sizeof (gint64));
+  processing = g_array_new (FALSE, FALSE, sizeof (gint64));
+  total = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  for (guint i = 0; i < r->events->len; i++)
+    {
+      Event *ev = g_ptr_array_index (r->events, i);
+      gint64 dt;
+
+      if (ev->settled == 0)
+        continue;
+
+      if (first == 0)
+        first = ev->injected;
+
+      dt = ev->delivered - ev->injected;
+      g_array_append_val (delivery, dt);
+
+      dt = ev->settled - ev->delivered;
+      g_array_append_val (processing, dt);
+
+      dt = ev->settled - ev->injected;
+      g_array_append_val (total, dt);
+
+      count++;
+    }
+
+  wall = first > 0 ? r->end - first : 0;
+
+  g_print ("replayed %u events in %.3f ms (%s)",
+           count, (double) wall / 1000.0,
+           r->fast ? "fast" : "timed");
+
+  if (wall > 0)
+    g_print (", %.1f events/s",
+             (double) count * G_USEC_PER_SEC / (double) wall);
+
+  g_print ("\nignored: %u, skipped: %u, lost: %u\n\n",
+           r->ignored, r->skipped, r->lost);
+
+  g_print ("%-12s %10s %10s %10s %10s %10s   [ms]\n",
+           "stage", "min", "avg", "p50", "p95", "max");
+
+  replay_report_stage ("delivery", delivery);
+  replay_report_stage ("processing", processing);
+  replay_report_stage ("end-to-end", total);
+}
+
+static int
+replay (int argc, char **argv)
+{
+  g_autoptr(GOptionContext) optctx = NULL;
+  g_autoptr(GError) err = NULL;
+  g_autoptr(GTestDBus) dbus = NULL;
+  g_autoptr(GDBusConnection) bus = NULL;
+  g_auto(BoltTmpDir) dbdir = NULL;
+  const char *filter[] = {"thunderbolt", NULL};
+  Replay r = { NULL, };
+  gboolean fast = FALSE;
+  gboolean ok;
+  int res = EXIT_FAILURE;
+  GOptionEntry options[] = {
+    { "fast", 'f', 0, G_OPTION_ARG_NONE, &fast, "Replay as fast as possible", NULL },
+    { NULL }
+  };
+
+  optctx = g_option_context_new ("FILE - Replay recorded uevents");
+  g_option_context_add_main_entries (optctx, options, NULL);
+
+  if (!g_option_context_parse (optctx, &argc, &argv, &err))
+    {
+      g_printerr ("%s\n", err->message);
+      return EXIT_FAILURE;
+    }
+
+  if (argc != 2)
+    {
+      g_printerr ("need exactly one recording to replay\n");
+      return EXIT_FAILURE;
+    }
+
+  if (!umockdev_in_mock_environment ())
+    {
+      g_printerr ("must be run via 'umockdev-wrapper'\n");
+      return EXIT_FAILURE;
+    }
+
+  r.kf = g_key_file_new ();
+  r.fast = fast;
+  r.events = g_ptr_array_new_with_free_func (event_free);
+  r.delivered = g_ptr_array_new ();
+  r.domains = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  r.devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  g_queue_init (&r.inflight);
+
+  ok = replay_load (&r, argv[1], &err);
+  if (!ok)
+    {
+      g_printerr ("could not load recording: %s\n", err->message);
+      goto out;
+    }
+
+  /* the manager's store and its bus, which also stands
+   * in for the system bus, where polkit is looked up */
+  dbdir = bolt_tmp_dir_make ("bolt.replay.XXXXXX", &err);
+  if (dbdir == NULL)
+    {
+      g_printerr ("could not create database dir: %s\n", err->message);
+      goto out;
+    }
+
+  g_setenv ("BOLT_DBPATH", dbdir, TRUE);
+
+  dbus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (dbus);
+  g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address (dbus), TRUE);
+
+  bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &err);
+  if (bus == NULL)
+    {
+      g_printerr ("could not connect to bus: %s\n", err->message);
+      goto out;
+    }
+
+  r.sysfs = mock_sysfs_new ();
+  g_object_get (r.sysfs, "testbed", &r.bed, NULL);
+
+  /* created before the manager, so that in each main loop
+   * iteration its uevent source is dispatched first, and
+   * the delivery time does not include the processing */
+  r.udev = bolt_udev_new (BOLT_UDEV_SOURCE_UDEV, filter, &err);
+  if (r.udev == NULL)
+    {
+      g_printerr ("could not create udev monitor: %s\n", err->message);
+      goto out;
+    }
+
+  g_signal_connect (r.udev, "uevent", G_CALLBACK (replay_uevent), &r);
+
+  r.mgr = g_initable_new (BOLT_TYPE_MANAGER, NULL, &err, NULL);
+  if (r.mgr == NULL)
+    {
+      g_printerr ("could not create manager: %s\n", err->message);
+      goto out;
+    }
+
+  ok = bolt_manager_export (r.mgr, bus, &err);
+  if (!ok)
+    {
+      g_printerr ("could not export manager: %s\n", err->message);
+      goto out;
+    }
+
+  g_print ("replaying %u events from %s\n", r.events->len, argv[1]);
+
+  r.loop = g_main_loop_new (NULL, FALSE);
+  r.watchdog = g_timeout_add_seconds (REPLAY_STALL_TIMEOUT,
+                                      replay_watchdog, &r);
+  r.start = g_get_monotonic_time ();
+
+  replay_schedule (&r);
+
+  if (r.end == 0)
+    g_main_loop_run (r.loop);
+
+  replay_report (&r);
+  res = EXIT_SUCCESS;
+
+out:
+  if (r.watchdog)
+    g_source_remove (r.watchdog);
+  if (r.timer)
+    g_source_remove (r.timer);
+  if (r.settle)
+    g_source_remove (r.settle);
+
+  g_clear_object (&r.mgr);
+  g_clear_object (&r.udev);
+  g_clear_object (&r.bed);
+  g_clear_object (&r.sysfs);
+  g_clear_pointer (&r.loop, g_main_loop_unref);
+  g_clear_pointer (&r.domains, g_hash_table_unref);
+  g_clear_pointer (&r.devices, g_hash_table_unref);
+  g_clear_pointer (&r.delivered, g_ptr_array_unref);
+  g_clear_pointer (&r.events, g_ptr_array_unref);
+  g_clear_pointer (&r.kf, g_key_file_unref);
+  g_queue_clear (&r.inflight);
+
+  g_clear_object (&bus);
+
+  if (dbus != NULL)
+    g_test_dbus_down (dbus);
+
+  return res;
+}
+
+int
+main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+
+  if (argc > 1 && g_str_equal (argv[1], "record"))
+    return record (argc - 1, argv + 1);
+  else if (argc > 1 && g_str_equal (argv[1], "replay"))
+    return replay (argc - 1, argv + 1);
+
+  g_printerr ("usage: %s record|replay [OPTIONS] FILE\n", argv[0]);
+  return EXIT_FAILURE;
+}
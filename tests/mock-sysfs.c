@@ -314,6 +314,8 @@ mock_sysfs_device_unplug (MockSysfs  *ms,
 
   umockdev_testbed_uevent (ms->bed, dev->path, "remove");
   umockdev_testbed_remove_device (ms->bed, dev->path);
+
+  g_hash_table_remove (ms->devices, dev->idstr);
 }
 
 /* public methods: generic */
@@ -692,7 +694,7 @@ mock_sysfs_device_add (MockSysfs  *ms,
                                    domain,
                                    pdev->path,
                                    id,
-                                   1,
+                                   authorized,
                                    key,
                                    boot);
 
@@ -744,7 +746,7 @@ mock_sysfs_device_get_parent (MockSysfs  *ms,
       MockDevice *d = v;
       gpointer p;
 
-      p = g_hash_table_lookup (d->devices, dev->path);
+      p = g_hash_table_lookup (d->devices, dev->idstr);
       if (p != NULL)
         return d->idstr;
     }
@@ -752,6 +754,32 @@ mock_sysfs_device_get_parent (MockSysfs  *ms,
   return NULL;
 }
 
+static gboolean
+mock_sysfs_host_remove (MockSysfs  *ms,
+                        MockDevice *dev)
+{
+  GHashTableIter iter;
+  gpointer k, v;
+
+  /* the host is the only device without a parent
+   * device, it is directly below the domain */
+  g_hash_table_iter_init (&iter, ms->domains);
+  while (g_hash_table_iter_next (&iter, &k, &v))
+    {
+      MockDomain *domain = v;
+
+      if (domain->host != dev)
+        continue;
+
+      mock_sysfs_device_unplug (ms, dev);
+      g_clear_pointer (&domain->host, mock_device_destroy);
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 gboolean
 mock_sysfs_device_remove (MockSysfs  *ms,
                           const char *id)
@@ -771,14 +799,15 @@ mock_sysfs_device_remove (MockSysfs  *ms,
 
   mom = mock_sysfs_device_get_parent (ms, id);
   if (mom == NULL)
-    return FALSE;
+    return mock_sysfs_host_remove (ms, dev);
 
   m =  g_hash_table_lookup (ms->devices, mom);
   g_assert_nonnull (m);
 
   mock_sysfs_device_unplug (ms, dev);
+
+  /* the table owns the device, i.e. this destroys it */
   g_hash_table_remove (m->devices, id);
-  mock_device_destroy (dev);
 
   return TRUE;
 }
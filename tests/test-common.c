@@ -1272,6 +1272,69 @@ test_str_set (TestRng *tt, gconstpointer user_data)
   g_assert_cmpstr (target, ==, "Hallo Welt");
 }
 
+static void
+test_str_pool (TestRng *tt, gconstpointer user_data)
+{
+  g_autofree char *copy = NULL;
+  BoltStrPoolStats before;
+  BoltStrPoolStats stats;
+  BoltStrPoolStats shared;
+  const char *a;
+  const char *b;
+  const char *c;
+  const char *d;
+
+  g_assert_null (bolt_str_pool_ref (NULL));
+  bolt_str_pool_unref (NULL);
+
+  bolt_str_pool_stats (&before);
+
+  copy = g_strdup ("GNOME.org");
+  a = bolt_str_pool_ref ("GNOME.org");
+  b = bolt_str_pool_ref (copy);
+
+  g_assert_cmpstr (a, ==, "GNOME.org");
+  g_assert_true (a == b);
+
+  c = bolt_str_pool_ref ("Laptop");
+  g_assert_true (a != c);
+
+  bolt_str_pool_stats (&stats);
+  g_assert_cmpuint (stats.count, ==, before.count + 2);
+  g_assert_cmpuint (stats.refs, ==, before.refs + 3);
+  g_assert_cmpuint (stats.bytes, >, before.bytes + strlen (copy) + 1);
+  /* two new entries, but only one copy avoided */
+  g_assert_cmpint (stats.saved, <, before.saved + (gssize) strlen (copy) + 1);
+
+  /* every additional reference is a copy not made */
+  d = bolt_str_pool_ref (copy);
+  g_assert_true (a == d);
+
+  bolt_str_pool_stats (&shared);
+  g_assert_cmpuint (shared.bytes, ==, stats.bytes);
+  g_assert_cmpint (shared.saved, ==, stats.saved + (gssize) strlen (copy) + 1);
+
+  bolt_str_pool_unref (d);
+  bolt_str_pool_unref (b);
+  g_assert_cmpstr (a, ==, "GNOME.org");
+
+  /* replacing */
+  g_assert_false (bolt_set_str_pooled (&a, copy));
+  g_assert_true (bolt_set_str_pooled (&a, "Laptop"));
+  g_assert_true (a == c);
+
+  g_assert_true (bolt_set_str_pooled (&a, NULL));
+  g_assert_null (a);
+
+  bolt_str_pool_unref (c);
+
+  bolt_str_pool_stats (&stats);
+  g_assert_cmpuint (stats.count, ==, before.count);
+  g_assert_cmpuint (stats.refs, ==, before.refs);
+  g_assert_cmpuint (stats.bytes, ==, before.bytes);
+  g_assert_cmpint (stats.saved, ==, before.saved);
+}
+
 #define MAKE_GSTRV(...) (GStrv) (const char *[]){ __VA_ARGS__}
 
 static void
@@ -1783,6 +1846,13 @@ main (int argc, char **argv)
               test_str_set,
               NULL);
 
+  g_test_add ("/common/str/pool",
+              TestRng,
+              NULL,
+              NULL,
+              test_str_pool,
+              NULL);
+
   g_test_add ("/common/strv/equal",
               TestRng,
               NULL,
@@ -1080,6 +1080,203 @@ test_exported_props_changed (TestExported *tt, gconstpointer data)
   g_assert_true (have_str);
 }
 
+typedef struct StormCtx
+{
+  GMainLoop *loop;
+  guint      count;
+  char      *last;
+} StormCtx;
+
+static void
+props_storm_signal (GDBusConnection *connection,
+                    const gchar     *sender_name,
+                    const gchar     *object_path,
+                    const gchar     *interface_name,
+                    const gchar     *signal_name,
+                    GVariant        *parameters,
+                    gpointer         user_data)
+{
+  g_autoptr(GVariant) changed = NULL;
+  StormCtx *ctx = user_data;
+  const char *str = NULL;
+
+  g_variant_get_child (parameters, 1, "@a{sv}", &changed);
+
+  ctx->count++;
+
+  if (!g_variant_lookup (changed, "StrRW", "&s", &str))
+    return;
+
+  g_free (ctx->last);
+  ctx->last = g_strdup (str);
+
+  if (bolt_streq (str, "storm-final"))
+    g_main_loop_quit (ctx->loop);
+}
+
+static gboolean
+change_properties_storm (gpointer user_data)
+{
+  TestExported *tt = user_data;
+
+  /* without returning to the main loop nothing gets
+   * flushed, so the queue will be congested */
+  for (guint i = 0; i < 1000; i++)
+    {
+      g_autofree char *str = g_strdup_printf ("storm-%u", i);
+      g_object_set (tt->obj, "str-rw", str, NULL);
+    }
+
+  g_object_set (tt->obj, "str-rw", "storm-final", NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_exported_props_storm (TestExported *tt, gconstpointer data)
+{
+  StormCtx ctx = {NULL, };
+  guint sid;
+
+  ctx.loop = g_main_loop_new (NULL, FALSE);
+
+  sid = g_dbus_connection_signal_subscribe (tt->bus,
+                                            tt->bus_name,
+                                            "org.freedesktop.DBus.Properties",
+                                            "PropertiesChanged",
+                                            tt->obj_path,
+                                            DBUS_IFACE,
+                                            G_DBUS_SIGNAL_FLAGS_NONE,
+                                            props_storm_signal,
+                                            &ctx,
+                                            NULL);
+
+  g_assert_cmpuint (sid, >, 0);
+
+  g_idle_add (change_properties_storm, tt);
+
+  g_main_loop_run (ctx.loop);
+  g_dbus_connection_signal_unsubscribe (tt->bus, sid);
+
+  /* superseded changes were collapsed, but the
+   * final value must always make it through */
+  g_assert_cmpstr (ctx.last, ==, "storm-final");
+  g_assert_cmpstr (tt->obj->str, ==, "storm-final");
+  g_assert_cmpuint (ctx.count, <, 1001);
+
+  g_main_loop_unref (ctx.loop);
+  g_free (ctx.last);
+}
+
+typedef struct OverflowCtx
+{
+  GMainLoop *loop;
+  guint      resyncs;
+} OverflowCtx;
+
+static void
+overflow_resync_signal (GDBusConnection *connection,
+                        const gchar     *sender_name,
+                        const gchar     *object_path,
+                        const gchar     *interface_name,
+                        const gchar     *signal_name,
+                        GVariant        *parameters,
+                        gpointer         user_data)
+{
+  OverflowCtx *ctx = user_data;
+
+  ctx->resyncs++;
+  g_main_loop_quit (ctx->loop);
+}
+
+static gboolean
+emit_signals_overflow (gpointer user_data)
+{
+  TestExported *tt = user_data;
+
+  /* more than the queue limit (1024), without returning to
+   * the main loop, so that nothing can be flushed */
+  for (guint i = 0; i < 1100; i++)
+    {
+      g_autoptr(GError) err = NULL;
+      gboolean ok;
+
+      ok = bolt_exported_emit_signal (BOLT_EXPORTED (tt->obj),
+                                      "Tick",
+                                      g_variant_new ("(u)", i),
+                                      &err);
+      g_assert_no_error (err);
+      g_assert_true (ok);
+    }
+
+  /* dropped as well, covered by the resync */
+  g_object_set (tt->obj, "str-rw", "overflow-final", NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_exported_signals_overflow (TestExported *tt, gconstpointer data)
+{
+  g_autoptr(CallCtx) call = NULL;
+  g_autoptr(GVariant) v = NULL;
+  OverflowCtx ctx = {NULL, };
+  const char *str;
+  guint sid;
+
+  ctx.loop = g_main_loop_new (NULL, FALSE);
+  bolt_exported_set_resync_signal (BOLT_EXPORTED (tt->obj), "Resync");
+
+  sid = g_dbus_connection_signal_subscribe (tt->bus,
+                                            tt->bus_name,
+                                            DBUS_IFACE,
+                                            "Resync",
+                                            tt->obj_path,
+                                            NULL,
+                                            G_DBUS_SIGNAL_FLAGS_NONE,
+                                            overflow_resync_signal,
+                                            &ctx,
+                                            NULL);
+
+  g_assert_cmpuint (sid, >, 0);
+
+  g_idle_add (emit_signals_overflow, tt);
+  g_main_loop_run (ctx.loop);
+
+  /* give a possible second resync the chance to show up */
+  call = call_ctx_new ();
+  g_dbus_connection_call (tt->bus,
+                          tt->bus_name,
+                          tt->obj_path,
+                          "org.freedesktop.DBus.Properties",
+                          "Get",
+                          g_variant_new ("(ss)",
+                                         DBUS_IFACE,
+                                         "StrRW"),
+                          G_VARIANT_TYPE ("(v)"),
+                          G_DBUS_CALL_FLAGS_NONE,
+                          2000,
+                          NULL,
+                          dbus_call_done,
+                          call);
+
+  call_ctx_run (call);
+  g_dbus_connection_signal_unsubscribe (tt->bus, sid);
+
+  g_assert_cmpuint (ctx.resyncs, ==, 1);
+
+  /* after the resync, the current value can be read */
+  g_assert_no_error (call->error);
+  g_assert_nonnull (call->data);
+
+  g_variant_get (call->data, "(v)", &v);
+  str = g_variant_get_string (v, NULL);
+  g_assert_cmpstr (str, ==, "overflow-final");
+
+  bolt_exported_set_resync_signal (BOLT_EXPORTED (tt->obj), NULL);
+  g_main_loop_unref (ctx.loop);
+}
+
 static void
 test_exported_props_enums (TestExported *tt, gconstpointer data)
 {
@@ -1331,6 +1528,20 @@ main (int argc, char **argv)
               test_exported_props_changed,
               test_exported_teardown);
 
+  g_test_add ("/exported/props/storm",
+              TestExported,
+              NULL,
+              test_exported_setup,
+              test_exported_props_storm,
+              test_exported_teardown);
+
+  g_test_add ("/exported/signals/overflow",
+              TestExported,
+              NULL,
+              test_exported_setup,
+              test_exported_signals_overflow,
+              test_exported_teardown);
+
   g_test_add ("/exported/props/enums",
               TestExported,
               NULL,
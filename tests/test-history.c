@@ -0,0 +1,248 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "bolt-history.h"
+
+#include "bolt-fs.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <locale.h>
+
+
+typedef struct
+{
+  char  *path;
+  GFile *root;
+} TestHistory;
+
+
+static void
+test_history_setup (TestHistory *tt, gconstpointer user_data)
+{
+  g_autoptr(GError) error = NULL;
+
+  tt->path = g_dir_make_tmp ("bolt.history.XXXXXX",
+                             &error);
+
+  if (tt->path == NULL)
+    {
+      g_critical ("Could not create tmp dir: %s",
+                  error->message);
+      return;
+    }
+
+  g_debug ("history test path at: %s", tt->path);
+
+  tt->root = g_file_new_for_path (tt->path);
+}
+
+
+static void
+test_history_tear_down (TestHistory *tt, gconstpointer user_data)
+{
+  g_autoptr(GError) error = NULL;
+  gboolean ok;
+
+  ok = bolt_fs_cleanup_dir (tt->path, &error);
+
+  if (!ok)
+    g_warning ("Could not clean up dir: %s", error->message);
+
+  g_clear_object (&tt->root);
+  g_clear_pointer (&tt->path, g_free);
+}
+
+static void
+test_history_basic (TestHistory *tt, gconstpointer user_data)
+{
+  g_autoptr(BoltHistory) h = NULL;
+  g_autoptr(GPtrArray) res = NULL;
+  g_autoptr(GError) err = NULL;
+  BoltHistoryEntry *e;
+  guint64 mid;
+  gboolean ok;
+
+  h = bolt_history_new (tt->root, "history", &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (h);
+
+  g_assert_cmpuint (bolt_history_get_count (h), ==, 0);
+
+  ok = bolt_history_put (h, "dev-a", BOLT_HISTORY_CONNECT,
+                         BOLT_HISTORY_RESULT_NONE, 0, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+
+  ok = bolt_history_put (h, "dev-b", BOLT_HISTORY_CONNECT,
+                         BOLT_HISTORY_RESULT_NONE, 0, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+
+  g_usleep (10);
+  mid = (guint64) g_get_real_time ();
+  g_usleep (10);
+
+  ok = bolt_history_put (h, "dev-a", BOLT_HISTORY_AUTHORIZE,
+                         BOLT_HISTORY_RESULT_OK, 42, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+
+  ok = bolt_history_put (h, "dev-ab", BOLT_HISTORY_ENROLL,
+                         BOLT_HISTORY_RESULT_NONE, 0, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+
+  g_assert_cmpuint (bolt_history_get_count (h), ==, 4);
+
+  /* all entries, newest first */
+  res = bolt_history_query (h, NULL, 0, 0, 0, &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (res);
+  g_assert_cmpuint (res->len, ==, 4);
+
+  e = g_ptr_array_index (res, 0);
+  g_assert_cmpstr (e->uid, ==, "dev-ab");
+  g_assert_cmpint (e->event, ==, BOLT_HISTORY_ENROLL);
+
+  for (guint i = 1; i < res->len; i++)
+    {
+      BoltHistoryEntry *a = g_ptr_array_index (res, i - 1);
+      BoltHistoryEntry *b = g_ptr_array_index (res, i);
+      g_assert_cmpuint (a->ts, >=, b->ts);
+    }
+
+  g_clear_pointer (&res, g_ptr_array_unref);
+
+  /* by uid, a prefix must not match */
+  res = bolt_history_query (h, "dev-a", 0, 0, 0, &err);
+  g_assert_no_error (err);
+  g_assert_cmpuint (res->len, ==, 2);
+
+  e = g_ptr_array_index (res, 0);
+  g_assert_cmpstr (e->uid, ==, "dev-a");
+  g_assert_cmpint (e->event, ==, BOLT_HISTORY_AUTHORIZE);
+  g_assert_cmpint (e->result, ==, BOLT_HISTORY_RESULT_OK);
+  g_assert_cmpuint (e->duration, ==, 42);
+
+  e = g_ptr_array_index (res, 1);
+  g_assert_cmpint (e->event, ==, BOLT_HISTORY_CONNECT);
+  g_assert_cmpint (e->result, ==, BOLT_HISTORY_RESULT_NONE);
+  g_clear_pointer (&res, g_ptr_array_unref);
+
+  /* time range */
+  res = bolt_history_query (h, NULL, mid, 0, 0, &err);
+  g_assert_no_error (err);
+  g_assert_cmpuint (res->len, ==, 2);
+  g_clear_pointer (&res, g_ptr_array_unref);
+
+  res = bolt_history_query (h, NULL, 0, mid, 0, &err);
+  g_assert_no_error (err);
+  g_assert_cmpuint (res->len, ==, 2);
+  e = g_ptr_array_index (res, 0);
+  g_assert_cmpstr (e->uid, ==, "dev-b");
+  g_clear_pointer (&res, g_ptr_array_unref);
+
+  /* limit */
+  res = bolt_history_query (h, NULL, 0, 0, 1, &err);
+  g_assert_no_error (err);
+  g_assert_cmpuint (res->len, ==, 1);
+  e = g_ptr_array_index (res, 0);
+  g_assert_cmpstr (e->uid, ==, "dev-ab");
+  g_clear_pointer (&res, g_ptr_array_unref);
+
+  /* reopening keeps the records */
+  g_clear_object (&h);
+  h = bolt_history_new (tt->root, "history", &err);
+  g_assert_no_error (err);
+  g_assert_cmpuint (bolt_history_get_count (h), ==, 4);
+}
+
+static void
+test_history_compact (TestHistory *tt, gconstpointer user_data)
+{
+  g_autoptr(BoltHistory) h = NULL;
+  g_autoptr(GPtrArray) res = NULL;
+  g_autoptr(GError) err = NULL;
+  BoltHistoryEntry *e;
+
+  h = bolt_history_new (tt->root, "history", &err);
+  g_assert_no_error (err);
+
+  bolt_history_set_limits (h, 8, G_USEC_PER_SEC * 60 * 60);
+
+  for (guint i = 0; i < 32; i++)
+    {
+      g_autofree char *uid = g_strdup_printf ("dev-%02u", i);
+      gboolean ok;
+
+      ok = bolt_history_put (h, uid, BOLT_HISTORY_CONNECT,
+                             BOLT_HISTORY_RESULT_NONE, 0, &err);
+      g_assert_no_error (err);
+      g_assert_true (ok);
+
+      /* compaction is done from an idle source */
+      if (i == 9)
+        g_assert_cmpuint (bolt_history_get_count (h), ==, 10);
+
+      while (g_main_context_iteration (NULL, FALSE))
+        ;
+
+      /* max records plus some slack */
+      g_assert_cmpuint (bolt_history_get_count (h), <=, 9);
+    }
+
+  res = bolt_history_query (h, NULL, 0, 0, 0, &err);
+  g_assert_no_error (err);
+  g_assert_cmpuint (res->len, >=, 8);
+
+  /* the newest records survive */
+  e = g_ptr_array_index (res, 0);
+  g_assert_cmpstr (e->uid, ==, "dev-31");
+  e = g_ptr_array_index (res, res->len - 1);
+  g_assert_cmpstr (e->uid, !=, "dev-00");
+}
+
+int
+main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/history/basic",
+              TestHistory,
+              NULL,
+              test_history_setup,
+              test_history_basic,
+              test_history_tear_down);
+
+  g_test_add ("/history/compact",
+              TestHistory,
+              NULL,
+              test_history_setup,
+              test_history_compact,
+              test_history_tear_down);
+
+  return g_test_run ();
+}
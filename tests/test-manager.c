@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "bolt-clock.h"
+#include "bolt-enums.h"
+#include "bolt-manager.h"
+
+#include "bolt-test.h"
+#include "mock-sysfs.h"
+
+#include "bolt-daemon-resource.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <locale.h>
+
+typedef struct
+{
+  MockSysfs  *sysfs;
+  BoltClock  *clock;
+  GTestDBus  *dbus;
+  BoltTmpDir  dbdir;
+  BoltTmpDir  rundir;
+} TestManager;
+
+
+static void
+test_manager_setup (TestManager *tt, gconstpointer data)
+{
+  g_autoptr(GError) err = NULL;
+
+  tt->dbdir = bolt_tmp_dir_make ("bolt.manager.db.XXXXXX", &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (tt->dbdir);
+
+  tt->rundir = bolt_tmp_dir_make ("bolt.manager.run.XXXXXX", &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (tt->rundir);
+
+  g_setenv ("BOLT_DBPATH", tt->dbdir, TRUE);
+  g_setenv ("BOLT_RUNDIR", tt->rundir, TRUE);
+
+  /* the bouncer looks up polkit on the system bus */
+  tt->dbus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (tt->dbus);
+  g_setenv ("DBUS_SYSTEM_BUS_ADDRESS",
+            g_test_dbus_get_bus_address (tt->dbus),
+            TRUE);
+
+  tt->sysfs = mock_sysfs_new ();
+  tt->clock = bolt_clock_new_virtual ();
+}
+
+static void
+test_manager_tear_down (TestManager *tt, gconstpointer user)
+{
+  g_clear_object (&tt->clock);
+  g_clear_object (&tt->sysfs);
+
+  g_test_dbus_down (tt->dbus);
+  g_clear_object (&tt->dbus);
+
+  g_clear_pointer (&tt->rundir, bolt_tmp_dir_destroy);
+  g_clear_pointer (&tt->dbdir, bolt_tmp_dir_destroy);
+
+  g_unsetenv ("BOLT_DBPATH");
+  g_unsetenv ("BOLT_RUNDIR");
+}
+
+static BoltManager *
+make_manager (TestManager *tt)
+{
+  g_autoptr(GError) err = NULL;
+  BoltManager *mgr;
+
+  mgr = g_initable_new (BOLT_TYPE_MANAGER,
+                        NULL, &err,
+                        "clock", tt->clock,
+                        NULL);
+
+  g_assert_no_error (err);
+  g_assert_nonnull (mgr);
+
+  return mgr;
+}
+
+static BoltPowerState
+manager_power_state (BoltManager *mgr)
+{
+  BoltPowerState state;
+
+  g_object_get (mgr, "power-state", &state, NULL);
+  return state;
+}
+
+static void
+test_manager_power_wait (TestManager *tt, gconstpointer user)
+{
+  g_autoptr(BoltManager) mgr = NULL;
+  const char *fp;
+
+  /* no domain, but force power: the manager powers up the
+   * controller and waits 5 seconds for the domain */
+  fp = mock_sysfs_force_power_add (tt->sysfs);
+  g_assert_nonnull (fp);
+
+  mgr = make_manager (tt);
+
+  g_assert_cmpint (manager_power_state (mgr), ==, BOLT_FORCE_POWER_ON);
+  g_assert_true (mock_sysfs_force_power_enabled (tt->sysfs));
+
+  bolt_clock_advance (tt->clock, 5 * 1000 - 1);
+  g_assert_cmpint (manager_power_state (mgr), ==, BOLT_FORCE_POWER_ON);
+
+  /* the wait is over, the guard is released and the
+   * power controller goes into its own wait period */
+  bolt_clock_advance (tt->clock, 1);
+  g_assert_cmpint (manager_power_state (mgr), ==, BOLT_FORCE_POWER_WAIT);
+  g_assert_true (mock_sysfs_force_power_enabled (tt->sysfs));
+
+  bolt_clock_advance (tt->clock, 20 * 1000);
+  g_assert_cmpint (manager_power_state (mgr), ==, BOLT_FORCE_POWER_OFF);
+  g_assert_false (mock_sysfs_force_power_enabled (tt->sysfs));
+}
+
+static void
+on_idle (BoltManager *mgr, gpointer user_data)
+{
+  guint *count = user_data;
+
+  (*count)++;
+}
+
+static void
+test_manager_idle_exit (TestManager *tt, gconstpointer user)
+{
+  g_autoptr(BoltManager) mgr = NULL;
+  g_autoptr(GDBusConnection) bus = NULL;
+  g_autoptr(GError) err = NULL;
+  g_autofree char *cfg = NULL;
+  guint idle = 0;
+  gboolean ok;
+
+  cfg = g_build_filename (tt->dbdir, "boltd.conf", NULL);
+  ok = g_file_set_contents (cfg, "[config]\nIdleExitTimeout=30\n", -1, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+
+  mgr = make_manager (tt);
+  g_signal_connect (mgr, "idle", G_CALLBACK (on_idle), &idle);
+
+  /* exported, so that the dbus message filter is installed */
+  bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (bus);
+
+  ok = bolt_manager_export (mgr, bus, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+
+  bolt_manager_got_the_name (mgr);
+
+  bolt_clock_advance (tt->clock, 30 * 1000 - 1);
+  g_assert_cmpuint (idle, ==, 0);
+
+  bolt_clock_advance (tt->clock, 1);
+  g_assert_cmpuint (idle, ==, 1);
+
+  /* the check is not re-armed after the signal */
+  bolt_clock_advance (tt->clock, 60 * 1000);
+  g_assert_cmpuint (idle, ==, 1);
+
+  /* the filter holds its own reference to the activity
+   * counter, which must survive the manager going away */
+  g_clear_object (&mgr);
+  g_clear_object (&bus);
+}
+
+int
+main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_resources_register (bolt_daemon_get_resource ());
+
+  g_test_add ("/manager/power/wait",
+              TestManager,
+              NULL,
+              test_manager_setup,
+              test_manager_power_wait,
+              test_manager_tear_down);
+
+  g_test_add ("/manager/idle/exit",
+              TestManager,
+              NULL,
+              test_manager_setup,
+              test_manager_idle_exit,
+              test_manager_tear_down);
+
+  return g_test_run ();
+}
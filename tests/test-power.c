@@ -407,6 +407,56 @@ test_power_timeout (TestPower *tt, gconstpointer user)
   g_assert_false (on);
 }
 
+static void
+test_power_timeout_virtual (TestPower *tt, gconstpointer user)
+{
+  g_autoptr(BoltClock) clk = NULL;
+  g_autoptr(BoltPower) power = NULL;
+  g_autoptr(GError) err = NULL;
+  g_autoptr(BoltPowerGuard) guard = NULL;
+  BoltPowerState state;
+  const char *fp;
+  gboolean on;
+
+  fp = mock_sysfs_force_power_add (tt->sysfs);
+  g_assert_nonnull (fp);
+
+  clk = bolt_clock_new_virtual ();
+  g_assert_true (bolt_clock_is_virtual (clk));
+
+  power =  g_initable_new (BOLT_TYPE_POWER,
+                           NULL, &err,
+                           "udev", tt->udev,
+                           "clock", clk,
+                           "timeout", 10 * 1000,
+                           "rundir", tt->rundir,
+                           NULL);
+
+  g_assert_no_error (err);
+  g_assert_nonnull (power);
+
+  guard = bolt_power_acquire (power, &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (guard);
+
+  g_clear_object (&guard);
+  state = bolt_power_get_state (power);
+  g_assert (state == BOLT_FORCE_POWER_WAIT);
+
+  /* nothing happens until the clock is advanced */
+  bolt_clock_advance (clk, 10 * 1000 - 1);
+  state = bolt_power_get_state (power);
+  g_assert (state == BOLT_FORCE_POWER_WAIT);
+  on = mock_sysfs_force_power_enabled (tt->sysfs);
+  g_assert_true (on);
+
+  bolt_clock_advance (clk, 1);
+  state = bolt_power_get_state (power);
+  g_assert (state == BOLT_FORCE_POWER_OFF);
+  on = mock_sysfs_force_power_enabled (tt->sysfs);
+  g_assert_false (on);
+}
+
 static void
 test_power_recover_state (TestPower *tt, gconstpointer user)
 {
@@ -757,6 +807,13 @@ main (int argc, char **argv)
               test_power_timeout,
               test_power_tear_down);
 
+  g_test_add ("/power/timeout/virtual",
+              TestPower,
+              NULL,
+              test_power_setup,
+              test_power_timeout_virtual,
+              test_power_tear_down);
+
   g_test_add ("/power/recover",
               TestPower,
               NULL,
@@ -0,0 +1,237 @@
+/*
+ * Copyright © 2026 The bolt contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *       agent <agent@local>
+ */
+
+#include "config.h"
+
+#include "bolt-rules.h"
+
+#include <glib.h>
+
+#include <locale.h>
+
+typedef struct
+{
+  int dummy;
+} TestRules;
+
+static BoltRules *
+make_rules (const char *data, GError **error)
+{
+  g_autoptr(GKeyFile) kf = NULL;
+  gboolean ok;
+
+  kf = g_key_file_new ();
+  ok = g_key_file_load_from_data (kf, data, -1, G_KEY_FILE_NONE, error);
+
+  if (!ok)
+    return NULL;
+
+  return bolt_rules_new_from_keyfile (kf, error);
+}
+
+static void
+test_rules_match (TestRules *tt, gconstpointer user_data)
+{
+  g_autoptr(BoltRules) rules = NULL;
+  g_autoptr(GError) err = NULL;
+  BoltRuleAction action;
+  const char *label = NULL;
+  const char *rule = NULL;
+  BoltRuleQuery q = {
+    .parent = "host-uid",
+    .vendor = "GNOME.org",
+    .name = "Laptop",
+    .type = BOLT_DEVICE_PERIPHERAL,
+    .domain = "domain0",
+    .security = BOLT_SECURITY_USER,
+    .depth = 1,
+  };
+  const char *data =
+    "[rule deny-deep]\n"
+    "Depth=3\n"
+    "Action=deny\n"
+    "[rule gnome-dock]\n"
+    "Vendor=GNOME.org\n"
+    "Name=Dock\n"
+    "Action=auto\n"
+    "Label=Office Dock\n"
+    "[rule gnome-secure]\n"
+    "Vendor=GNOME.org\n"
+    "Security=secure\n"
+    "Action=manual\n"
+    "[rule gnome]\n"
+    "Vendor=GNOME.org\n"
+    "Action=label\n"
+    "Label=GNOME Device\n"
+    "[rule behind-dock]\n"
+    "Parent=dock-uid\n"
+    "Action=auto\n";
+
+  rules = make_rules (data, &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (rules);
+  g_assert_cmpuint (bolt_rules_get_count (rules), ==, 5);
+
+  /* vendor only */
+  action = bolt_rules_match (rules, &q, &rule, &label);
+  g_assert_cmpint (action, ==, BOLT_RULE_LABEL);
+  g_assert_cmpstr (rule, ==, "gnome");
+  g_assert_cmpstr (label, ==, "GNOME Device");
+
+  /* vendor and name, the earlier rule wins */
+  q.name = "Dock";
+  action = bolt_rules_match (rules, &q, &rule, &label);
+  g_assert_cmpint (action, ==, BOLT_RULE_AUTO);
+  g_assert_cmpstr (rule, ==, "gnome-dock");
+  g_assert_cmpstr (label, ==, "Office Dock");
+
+  q.name = "Laptop";
+  q.security = BOLT_SECURITY_SECURE;
+  action = bolt_rules_match (rules, &q, &rule, NULL);
+  g_assert_cmpint (action, ==, BOLT_RULE_MANUAL);
+  g_assert_cmpstr (rule, ==, "gnome-secure");
+
+  /* the first rule beats everything else */
+  q.depth = 3;
+  action = bolt_rules_match (rules, &q, &rule, NULL);
+  g_assert_cmpint (action, ==, BOLT_RULE_DENY);
+  g_assert_cmpstr (rule, ==, "deny-deep");
+
+  q.depth = 2;
+  q.vendor = "Other";
+  q.parent = "dock-uid";
+  action = bolt_rules_match (rules, &q, &rule, NULL);
+  g_assert_cmpint (action, ==, BOLT_RULE_AUTO);
+  g_assert_cmpstr (rule, ==, "behind-dock");
+
+  /* the earlier label only rule does not hide the
+   * policy of a later one, but still sets the label */
+  q.vendor = "GNOME.org";
+  q.security = BOLT_SECURITY_USER;
+  action = bolt_rules_match (rules, &q, &rule, &label);
+  g_assert_cmpint (action, ==, BOLT_RULE_AUTO);
+  g_assert_cmpstr (rule, ==, "behind-dock");
+  g_assert_cmpstr (label, ==, "GNOME Device");
+
+  /* nothing matches */
+  q.parent = NULL;
+  q.vendor = NULL;
+  action = bolt_rules_match (rules, &q, NULL, NULL);
+  g_assert_cmpint (action, ==, BOLT_RULE_NONE);
+}
+
+static void
+test_rules_many (TestRules *tt, gconstpointer user_data)
+{
+  g_autoptr(BoltRules) rules = NULL;
+  g_autoptr(GString) data = NULL;
+  g_autoptr(GError) err = NULL;
+  BoltRuleAction action;
+  const char *rule = NULL;
+  BoltRuleQuery q = {
+    .type = BOLT_DEVICE_PERIPHERAL,
+    .security = BOLT_SECURITY_USER,
+    .depth = 1,
+  };
+
+  data = g_string_new ("");
+  for (guint i = 0; i < 500; i++)
+    g_string_append_printf (data,
+                            "[rule vendor-%u]\n"
+                            "Vendor=Vendor %u\n"
+                            "Type=peripheral\n"
+                            "Action=%s\n",
+                            i, i, i % 2 ? "auto" : "manual");
+
+  rules = make_rules (data->str, &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (rules);
+  g_assert_cmpuint (bolt_rules_get_count (rules), ==, 500);
+
+  q.vendor = "Vendor 499";
+  action = bolt_rules_match (rules, &q, &rule, NULL);
+  g_assert_cmpint (action, ==, BOLT_RULE_AUTO);
+  g_assert_cmpstr (rule, ==, "vendor-499");
+
+  q.vendor = "Vendor 42";
+  action = bolt_rules_match (rules, &q, &rule, NULL);
+  g_assert_cmpint (action, ==, BOLT_RULE_MANUAL);
+  g_assert_cmpstr (rule, ==, "vendor-42");
+
+  q.type = BOLT_DEVICE_HOST;
+  action = bolt_rules_match (rules, &q, NULL, NULL);
+  g_assert_cmpint (action, ==, BOLT_RULE_NONE);
+}
+
+static void
+test_rules_invalid (TestRules *tt, gconstpointer user_data)
+{
+  const char *invalid[] = {
+    "[foo]\nAction=auto\n",
+    "[rule no-action]\nVendor=GNOME.org\n",
+    "[rule bad-action]\nAction=maybe\n",
+    "[rule bad-key]\nColor=blue\nAction=auto\n",
+    "[rule bad-type]\nType=toaster\nAction=auto\n",
+    "[rule bad-security]\nSecurity=high\nAction=auto\n",
+    "[rule bad-depth]\nDepth=-1\nAction=auto\n",
+    "[rule no-label]\nAction=label\n",
+  };
+
+  for (guint i = 0; i < G_N_ELEMENTS (invalid); i++)
+    {
+      g_autoptr(BoltRules) rules = NULL;
+      g_autoptr(GError) err = NULL;
+
+      rules = make_rules (invalid[i], &err);
+      g_assert_null (rules);
+      g_assert_nonnull (err);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/rules/match",
+              TestRules,
+              NULL,
+              NULL,
+              test_rules_match,
+              NULL);
+
+  g_test_add ("/rules/many",
+              TestRules,
+              NULL,
+              NULL,
+              test_rules_many,
+              NULL);
+
+  g_test_add ("/rules/invalid",
+              TestRules,
+              NULL,
+              NULL,
+              test_rules_invalid,
+              NULL);
+
+  return g_test_run ();
+}
@@ -247,6 +247,8 @@ test_store_config (TestStore *tt, gconstpointer user_data)
   BoltPolicy policy;
   gboolean ok;
   BoltTri tri;
+  guint window;
+  const char *source;
 
   kf = bolt_store_config_load (tt->store, &err);
   g_assert_error (err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
@@ -299,6 +301,46 @@ test_store_config (TestStore *tt, gconstpointer user_data)
   g_assert_no_error (err);
   g_assert (tri == TRI_YES);
   g_assert_cmpuint (authmode, ==, BOLT_AUTH_ENABLED);
+
+  /* coalesce window */
+  tri = bolt_config_load_coalesce_window (loaded, &window, &err);
+  g_assert_no_error (err);
+  g_assert (tri == TRI_NO);
+
+  g_key_file_set_uint64 (loaded, "config", "ChangeCoalesceWindow", 100000);
+  tri = bolt_config_load_coalesce_window (loaded, &window, &err);
+  g_assert_error (err, BOLT_ERROR, BOLT_ERROR_CFG);
+  g_assert (tri == TRI_ERROR);
+  g_clear_pointer (&err, g_error_free);
+
+  g_key_file_set_uint64 (loaded, "config", "ChangeCoalesceWindow", 50);
+  tri = bolt_config_load_coalesce_window (loaded, &window, &err);
+  g_assert_no_error (err);
+  g_assert (tri == TRI_YES);
+  g_assert_cmpuint (window, ==, 50);
+
+  /* uevent source */
+  tri = bolt_config_load_uevent_source (loaded, &source, &err);
+  g_assert_no_error (err);
+  g_assert (tri == TRI_NO);
+
+  g_key_file_set_string (loaded, "config", "UeventSource", "netlink");
+  tri = bolt_config_load_uevent_source (loaded, &source, &err);
+  g_assert_error (err, BOLT_ERROR, BOLT_ERROR_CFG);
+  g_assert (tri == TRI_ERROR);
+  g_clear_pointer (&err, g_error_free);
+
+  g_key_file_set_string (loaded, "config", "UeventSource", "kernel");
+  tri = bolt_config_load_uevent_source (loaded, &source, &err);
+  g_assert_no_error (err);
+  g_assert (tri == TRI_YES);
+  g_assert_cmpstr (source, ==, "kernel");
+
+  g_key_file_set_string (loaded, "config", "UeventSource", "auto");
+  tri = bolt_config_load_uevent_source (loaded, &source, &err);
+  g_assert_no_error (err);
+  g_assert (tri == TRI_YES);
+  g_assert_null (source);
 }
 
 static void
@@ -540,6 +582,25 @@ test_store_times (TestStore *tt, gconstpointer user_data)
   g_assert_cmpuint (connout, ==, connin);
   g_assert_cmpuint (authout, ==, authin);
 
+  /* queued updates, must be visible to readers right away */
+  connin = 9377000;
+  authin = 9377042;
+
+  bolt_store_queue_times (tt->store, uid,
+                          "conntime", connin,
+                          "authtime", authin,
+                          NULL);
+
+  connout = authout = 0;
+  bolt_store_get_times (tt->store, uid, &error,
+                        "authtime", &authout,
+                        "conntime", &connout,
+                        NULL);
+
+  g_assert_no_error (error);
+  g_assert_cmpuint (connout, ==, connin);
+  g_assert_cmpuint (authout, ==, authin);
+
   /* lets remove them again */
   ok = bolt_store_del_time (tt->store, uid,
                             "conntime",
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include "bolt-error.h"
 #include "bolt-macros.h"
 #include "bolt-store.h"
 #include "bolt-str.h"
@@ -38,6 +39,7 @@
 
 #include <libudev.h>
 #include <locale.h>
+#include <string.h>
 
 typedef struct udev_device udev_device;
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (udev_device, udev_device_unref);
@@ -63,6 +65,92 @@ test_sysfs_tear_down (TestSysfs *tt, gconstpointer user)
   g_clear_pointer (&tt->udev, udev_unref);
 }
 
+static void
+test_sysfs_dir (TestSysfs *tt, gconstpointer user)
+{
+  g_autoptr(BoltSysfsDir) dir = NULL;
+  g_autoptr(GError) err = NULL;
+  g_auto(GStrv) acl = NULL;
+  BoltDevInfo info;
+  const char *domain;
+  const char *host;
+  const char *dock;
+  const char *syspath;
+  char buf[64];
+  gboolean ok;
+  gssize n;
+  gint val;
+  MockDevId hostid = {
+    .vendor_id = 0x42,
+    .vendor_name = "GNOME.org",
+    .device_id = 0x42,
+    .device_name = "Laptop",
+    .unique_id = "884c6edd-7118-4b21-b186-b02d396ecca0",
+  };
+  MockDevId dockid = {
+    .vendor_id = 0x42,
+    .vendor_name = "GNOME.org",
+    .device_id = 0x42,
+    .device_name = "Thunderbolt Dock",
+    .unique_id = "884c6edd-7118-4b21-b186-b02d396ecca1",
+  };
+
+  domain = mock_sysfs_domain_add (tt->sysfs, BOLT_SECURITY_SECURE, NULL);
+  host = mock_sysfs_host_add (tt->sysfs, domain, &hostid);
+  dock = mock_sysfs_device_add (tt->sysfs, host, &dockid, 1, NULL, 1);
+  g_assert_nonnull (dock);
+
+  syspath = mock_sysfs_device_get_syspath (tt->sysfs, dock);
+
+  /* wrong uid */
+  dir = bolt_sysfs_dir_open (syspath, hostid.unique_id, &err);
+  g_assert_error (err, BOLT_ERROR, BOLT_ERROR_FAILED);
+  g_assert_null (dir);
+  g_clear_error (&err);
+
+  dir = bolt_sysfs_dir_open (syspath, dockid.unique_id, &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (dir);
+
+  g_assert_cmpstr (bolt_sysfs_dir_get_path (dir), ==, syspath);
+  g_assert_cmpint (bolt_sysfs_dir_get_fd (dir), >, -1);
+
+  n = bolt_sysfs_dir_read (dir, BOLT_SYSFS_UNIQUE_ID, buf, sizeof (buf), &err);
+  g_assert_no_error (err);
+  g_assert_cmpint (n, ==, (gssize) strlen (dockid.unique_id));
+  g_assert_cmpstr (buf, ==, dockid.unique_id);
+
+  /* reads are repeatable */
+  for (guint i = 0; i < 3; i++)
+    {
+      ok = bolt_sysfs_dir_read_int (dir, BOLT_SYSFS_AUTHORIZED, &val, &err);
+      g_assert_no_error (err);
+      g_assert_true (ok);
+      g_assert_cmpint (val, ==, 1);
+    }
+
+  ok = bolt_sysfs_dir_verify_uid (dir, hostid.unique_id, &err);
+  g_assert_error (err, BOLT_ERROR, BOLT_ERROR_FAILED);
+  g_assert_false (ok);
+  g_clear_error (&err);
+
+  ok = bolt_sysfs_dir_info (dir, &info, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+  g_assert_cmpint (info.authorized, ==, 1);
+  g_assert_cmpint (info.keysize, <, 0);
+  g_assert_cmpint (info.boot, ==, 1);
+  g_assert_false (info.full);
+
+  /* devices have no boot_acl, which is not an error */
+  ok = bolt_sysfs_dir_read_boot_acl (dir, &acl, &err);
+  g_assert_no_error (err);
+  g_assert_true (ok);
+  g_assert_null (acl);
+
+  mock_sysfs_domain_remove (tt->sysfs, domain);
+}
+
 static void
 count_domains (gpointer data,
                gpointer user_data)
@@ -982,6 +1070,13 @@ main (int argc, char **argv)
               test_sysfs_domain_for_device,
               test_sysfs_tear_down);
 
+  g_test_add ("/sysfs/dir",
+              TestSysfs,
+              NULL,
+              test_sysfs_setup,
+              test_sysfs_dir,
+              test_sysfs_tear_down);
+
   g_test_add ("/sysfs/domain/basic",
               TestSysfs,
               NULL,
@@ -207,6 +207,100 @@ test_udev_basic (TestUdev *tt, gconstpointer user)
   uevent_clear (&ev);
 }
 
+typedef struct
+{
+  GMainLoop *loop;
+  guint      batches;
+  guint      events;
+  guint      single;
+  guint      want;
+  gboolean   timedout;
+} UEventBatch;
+
+static void
+got_uevent_batch (BoltUdev  *udev,
+                  GPtrArray *batch,
+                  gpointer   user_data)
+{
+  UEventBatch *ub = user_data;
+
+  g_assert_cmpuint (batch->len, >, 0);
+
+  ub->batches++;
+  ub->events += batch->len;
+
+  for (guint i = 0; i < batch->len; i++)
+    {
+      struct udev_device *dev = g_ptr_array_index (batch, i);
+      g_assert_cmpstr (udev_device_get_action (dev), ==, "add");
+    }
+
+  if (ub->events >= ub->want)
+    g_main_loop_quit (ub->loop);
+}
+
+static void
+got_uevent_single (BoltUdev           *udev,
+                   const char         *action,
+                   struct udev_device *device,
+                   gpointer            user_data)
+{
+  UEventBatch *ub = user_data;
+
+  ub->single++;
+}
+
+static gboolean
+got_batch_timeout (gpointer user_data)
+{
+  UEventBatch *ub = user_data;
+
+  ub->timedout = TRUE;
+  g_main_loop_quit (ub->loop);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_udev_batch (TestUdev *tt, gconstpointer user)
+{
+  g_autoptr(GError) err = NULL;
+  g_autoptr(BoltUdev) udev = NULL;
+  UEventBatch ub = { NULL, };
+  const char *filter[] = {"thunderbolt", NULL};
+  guint tid;
+
+  udev = bolt_udev_new ("udev", filter, &err);
+
+  g_assert_no_error (err);
+  g_assert_nonnull (udev);
+
+  g_signal_connect (udev, "uevent-batch", (GCallback) got_uevent_batch, &ub);
+  g_signal_connect (udev, "uevent", (GCallback) got_uevent_single, &ub);
+
+  ub.loop = g_main_loop_new (NULL, FALSE);
+  ub.want = 3;
+
+  /* all three are queued before we get to receive */
+  for (guint i = 0; i < ub.want; i++)
+    mock_sysfs_domain_add (tt->sysfs, BOLT_SECURITY_NONE, NULL);
+
+  tid = g_timeout_add_seconds (2, got_batch_timeout, &ub);
+  g_main_loop_run (ub.loop);
+
+  if (!ub.timedout)
+    g_source_remove (tid);
+
+  g_assert_false (ub.timedout);
+  g_assert_cmpuint (ub.events, ==, ub.want);
+  /* queued before the loop ran, thus drained at once */
+  g_assert_cmpuint (ub.batches, ==, 1);
+
+  /* the single event signal is still emitted for each */
+  g_assert_cmpuint (ub.single, ==, ub.want);
+
+  g_main_loop_unref (ub.loop);
+}
+
 static void
 test_udev_detect_force_power (TestUdev *tt, gconstpointer user)
 {
@@ -280,6 +374,13 @@ main (int argc, char **argv)
               test_udev_basic,
               test_udev_tear_down);
 
+  g_test_add ("/udev/batch",
+              TestUdev,
+              NULL,
+              test_udev_setup,
+              test_udev_batch,
+              test_udev_tear_down);
+
   g_test_add ("/udev/detect_force_power",
               TestUdev,
               NULL,